@@ -26,8 +26,10 @@
 /*Color depth: 1 (1 byte per pixel), 8 (RGB332), 16 (RGB565), 32 (ARGB8888)*/
 #define LV_COLOR_DEPTH 16
 
-/*Swap the 2 bytes of RGB565 color. Useful if the display has an 8-bit interface (e.g. SPI)*/
-#define LV_COLOR_16_SWAP 0
+/*Swap the 2 bytes of RGB565 color. Useful if the display has an 8-bit interface (e.g. SPI)
+ *The ILI9341 takes RGB565 MSB first and the HSPI FIFO goes out in memory order, so LVGL renders
+ *in wire order and the transmit path never touches a pixel byte*/
+#define LV_COLOR_16_SWAP 1
 
 /*Enable features to draw on transparent background.
  *It's required if opa, and transform_* style properties are used.
@@ -85,10 +87,10 @@
 
 /*Use a custom tick source that tells the elapsed time in milliseconds.
  *It removes the need to manually update the tick with `lv_tick_inc()`)*/
-#define LV_TICK_CUSTOM 0
+#define LV_TICK_CUSTOM 1
 #if LV_TICK_CUSTOM
-    #define LV_TICK_CUSTOM_INCLUDE "Arduino.h"         /*Header for the system time function*/
-    #define LV_TICK_CUSTOM_SYS_TIME_EXPR (millis())    /*Expression evaluating to current system time in ms*/
+    #define LV_TICK_CUSTOM_INCLUDE "lvgl_tick.h"       /*Header for the system time function*/
+    #define LV_TICK_CUSTOM_SYS_TIME_EXPR (lvgl_tick_get())    /*Expression evaluating to current system time in ms*/
 #endif   /*LV_TICK_CUSTOM*/
 
 /*Default Dot Per Inch. Used to initialize default sizes such as widgets sized, style paddings.
@@ -318,10 +320,14 @@
 #define LV_ATTRIBUTE_TIMER_HANDLER
 
 /*Define a custom attribute to `lv_disp_flush_ready` function*/
-#define LV_ATTRIBUTE_FLUSH_READY
+/*Called from the SPI ISR when the async flush completes, so keep it in IRAM.
+ *The sdkconfig build (CONFIG_LV_CONF_SKIP) places it through main/linker.lf instead*/
+#include "esp_attr.h"
+#define LV_ATTRIBUTE_FLUSH_READY IRAM_ATTR
 
 /*Required alignment size for buffers*/
-#define LV_ATTRIBUTE_MEM_ALIGN_SIZE 1
+/*4 for the zero-copy SPI transmit, CONFIG_LV_ATTRIBUTE_MEM_ALIGN_SIZE in sdkconfig has to match*/
+#define LV_ATTRIBUTE_MEM_ALIGN_SIZE 4
 
 /*Will be added where memories needs to be aligned (with -Os data might not be aligned to boundary by default).
  * E.g. __attribute__((aligned(4)))*/
@@ -334,7 +340,10 @@
 #define LV_ATTRIBUTE_LARGE_RAM_ARRAY
 
 /*Place performance critical functions into a faster memory (e.g RAM)*/
-#define LV_ATTRIBUTE_FAST_MEM
+/*The sw fill/blend kernels run from IRAM instead of through the flash cache, see main/linker.lf
+ *for the rest of the profile-selected functions. Comment out to give the IRAM back to the heap.
+ *CONFIG_LV_ATTRIBUTE_FAST_MEM_USE_IRAM is the same with CONFIG_LV_CONF_SKIP*/
+#define LV_ATTRIBUTE_FAST_MEM IRAM_ATTR
 
 /*Prefix variables that are used in GPU accelerated operations, often these need to be placed in RAM sections that are DMA accessible*/
 #define LV_ATTRIBUTE_DMA
@@ -715,6 +724,35 @@
 
 /*Benchmark your system*/
 #define LV_USE_DEMO_BENCHMARK 1
+#if LV_USE_DEMO_BENCHMARK
+/*Print the per scene results when ready: 0: none, 1: CSV, 2: JSON*/
+#define LV_DEMO_BENCHMARK_REPORT 1
+/*Drop the rendered pixels instead of flushing them, to time rendering without the display*/
+#define LV_DEMO_BENCHMARK_VIRTUAL_DISP 0
+/*Refreshes in the first ms of every scene are not measured*/
+#define LV_DEMO_BENCHMARK_WARMUP_MS 200
+/*Run every scene this many times, the results are summed up*/
+#define LV_DEMO_BENCHMARK_REPEAT 1
+/*Before benchmarking, render every scene with a simulated tick and compare the CRC32 of the
+ *flushed areas against lv_demo_benchmark_golden.h*/
+#define LV_DEMO_BENCHMARK_VERIFY 0
+#if LV_DEMO_BENCHMARK_VERIFY
+#define LV_DEMO_BENCHMARK_VERIFY_FRAMES 8
+#define LV_DEMO_BENCHMARK_VERIFY_FRAME_MS 33
+#endif
+/*4x4 areas invalidated per frame by the "Flush 4x4 areas" scene. LVGL keeps LV_INV_BUF_SIZE (32)
+ *dirty areas and refreshes the whole screen beyond that, the scene stays 4 below it*/
+#define LV_DEMO_BENCHMARK_TINY_NUM 28
+/*Append the FPS of every run to this file and flag the scenes that got slower than in
+ *the run before by more than REGRESS_PCT percent. Comment out to disable*/
+#define LV_DEMO_BENCHMARK_STORE_PATH "/spiffs/benchmark.bin"
+/*Runs kept in the file before it starts over*/
+#define LV_DEMO_BENCHMARK_STORE_MAX 16
+#define LV_DEMO_BENCHMARK_REGRESS_PCT 10
+/*Print the FPS change of every scene against the run before, not only the regressions,
+ *e.g. to compare two builds that place different functions into IRAM*/
+#define LV_DEMO_BENCHMARK_DELTA 1
+#endif
 
 /*Stress test for LVGL*/
 #define LV_USE_DEMO_STRESS 1
@@ -10,6 +10,20 @@
 
 #if 1
 
+#include <stdio.h>
+#include <string.h>
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#include "lvgl_helpers.h"
+#include "lvgl_tick.h"
+#endif
+
+#if defined(ESP_PLATFORM) && LVGL_FLUSH_STATS
+#define FLUSH_STATS     1
+#else
+#define FLUSH_STATS     0
+#endif
+
 /*********************
  *      DEFINES
  *********************/
@@ -42,10 +56,93 @@
 #define LINE_POINT_DIFF_MAX LV_MAX(LV_HOR_RES / (LINE_POINT_NUM + 2), LINE_POINT_DIFF_MIN * 2)
 #define ARC_WIDTH_THIN LV_MAX(LV_DPI_DEF / 50, 2)
 #define ARC_WIDTH_THICK LV_MAX(LV_DPI_DEF / 10, 5)
+#define SCALE(v)        LV_MAX(((v) * (int32_t)size_pct) / 100, 1)
+#define TINY_SIZE       4
+#define TINY_PITCH      (TINY_SIZE * 3)
+#define STRIP_NUM       8
+#define SCROLL_STRIPE_NUM 12
+
+#ifndef LV_DEMO_BENCHMARK_REPORT
+#define LV_DEMO_BENCHMARK_REPORT 0
+#endif
+#ifndef LV_DEMO_BENCHMARK_VIRTUAL_DISP
+#define LV_DEMO_BENCHMARK_VIRTUAL_DISP 0
+#endif
+
+#ifndef LV_DEMO_BENCHMARK_WARMUP_MS
+#define LV_DEMO_BENCHMARK_WARMUP_MS 0
+#endif
+#ifndef LV_DEMO_BENCHMARK_REPEAT
+#define LV_DEMO_BENCHMARK_REPEAT 1
+#endif
+#ifndef LV_DEMO_BENCHMARK_VERIFY
+#define LV_DEMO_BENCHMARK_VERIFY 0
+#endif
+#ifndef LV_DEMO_BENCHMARK_VERIFY_FRAMES
+#define LV_DEMO_BENCHMARK_VERIFY_FRAMES 8
+#endif
+#ifndef LV_DEMO_BENCHMARK_VERIFY_FRAME_MS
+#define LV_DEMO_BENCHMARK_VERIFY_FRAME_MS 33
+#endif
+#ifndef LV_DEMO_BENCHMARK_TINY_NUM
+#define LV_DEMO_BENCHMARK_TINY_NUM 24
+#endif
+#ifndef LV_DEMO_BENCHMARK_STORE_MAX
+#define LV_DEMO_BENCHMARK_STORE_MAX 16
+#endif
+#ifndef LV_DEMO_BENCHMARK_REGRESS_PCT
+#define LV_DEMO_BENCHMARK_REGRESS_PCT 10
+#endif
+#ifndef LV_DEMO_BENCHMARK_DELTA
+#define LV_DEMO_BENCHMARK_DELTA 0
+#endif
+
+/*More dirty areas than LVGL can hold would turn into a full screen refresh,
+ *leave a few for the title and the subtitle*/
+#define TINY_NUM        LV_MIN(LV_DEMO_BENCHMARK_TINY_NUM, LV_INV_BUF_SIZE - 4)
+
+/*The verification drives the tick itself. A custom tick source has no lv_tick_inc(),
+ *the one of lvgl_tick.h can be frozen and advanced instead*/
+#if !LV_TICK_CUSTOM
+#define TICK_HOLD(en)
+#define TICK_INC(ms)    lv_tick_inc(ms)
+#elif defined(ESP_PLATFORM)
+#define TICK_HOLD(en)   lvgl_tick_hold(en)
+#define TICK_INC(ms)    lvgl_tick_inc(ms)
+#elif LV_DEMO_BENCHMARK_VERIFY
+#error "LV_DEMO_BENCHMARK_VERIFY needs lv_tick_inc() or lvgl_tick.h"
+#endif
+
+/*1 ms per bucket, longer refreshes land in the last one*/
+#define HIST_SIZE       128
+
+#define REPORT_NONE     0
+#define REPORT_CSV      1
+#define REPORT_JSON     2
+
+#define SCENE_CNT       (sizeof(scenes) / sizeof(scene_dsc_t) - 1)
+#define STORE_MAGIC     0x31484342      /*"BCH1"*/
+#define STORE_VERSION_LEN 32
 /**********************
  *      TYPEDEFS
  **********************/
 
+/*Refresh time distribution of a scene in ms*/
+typedef struct {
+    uint16_t min;
+    uint16_t p50;
+    uint16_t p95;
+    uint16_t p99;
+    uint16_t max;
+}frame_stat_t;
+
+typedef struct {
+    const char * target;    /*lv_demo_benchmark_set_target() of the build the CRCs were taken on*/
+    const char * name;
+    uint32_t crc_normal;
+    uint32_t crc_opa;
+}golden_dsc_t;
+
 typedef struct {
     const char * name;
     void (*create_cb)(void);
@@ -55,9 +152,40 @@ typedef struct {
     uint32_t refr_cnt_opa;
     uint32_t fps_normal;
     uint32_t fps_opa;
+    uint32_t render_us_normal;
+    uint32_t render_us_opa;
+    uint32_t spi_us_normal;         /*rendering blocked on the transport*/
+    uint32_t spi_us_opa;
+    uint32_t ovh_us_normal;         /*CPU time of the flushes themselves*/
+    uint32_t ovh_us_opa;
+    uint32_t flush_cnt_normal;
+    uint32_t flush_cnt_opa;
+    uint32_t bytes_normal;
+    uint32_t bytes_opa;
+    uint32_t px_normal;
+    uint32_t px_opa;
+    frame_stat_t stat_normal;
+    frame_stat_t stat_opa;
+    uint32_t crc_normal;
+    uint32_t crc_opa;
     uint8_t weight;
+    bool transport;                 /*Little to draw, a lot to flush, not in the weighted FPS*/
 }scene_dsc_t;
 
+/*A run in LV_DEMO_BENCHMARK_STORE_PATH: the header, then scene_cnt store_scene_t*/
+typedef struct {
+    uint32_t magic;
+    uint32_t scenes_crc;            /*CRC32 of the scene names and the target, runs of another scene list or target are not compared*/
+    uint16_t scene_cnt;
+    uint16_t fps_weighted;
+    char version[STORE_VERSION_LEN];
+}store_hdr_t;
+
+typedef struct {
+    uint16_t fps_normal;
+    uint16_t fps_opa;
+}store_scene_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
@@ -65,6 +193,11 @@ typedef struct {
 static lv_style_t style_common;
 static bool opa_mode = true;
 
+/*Scene parameters, OBJ_NUM, IMG_NUM and 100% unless a sweep step changes them*/
+static uint32_t obj_num = OBJ_NUM;
+static uint32_t img_num = IMG_NUM;
+static uint32_t size_pct = 100;
+
 LV_IMG_DECLARE(img_benchmark_cogwheel_argb);
 LV_IMG_DECLARE(img_benchmark_cogwheel_rgb);
 LV_IMG_DECLARE(img_benchmark_cogwheel_chroma_keyed);
@@ -76,12 +209,48 @@ LV_FONT_DECLARE(lv_font_benchmark_montserrat_16_compr_az);
 LV_FONT_DECLARE(lv_font_benchmark_montserrat_28_compr_az);
 
 static void monitor_cb(lv_disp_drv_t * drv, uint32_t time, uint32_t px);
+static void refr_timer_cb(lv_timer_t * timer);
+static void flush_cb(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_p);
+static void wait_cb(lv_disp_drv_t * drv);
+static uint32_t time_us(void);
+static void report_print(void);
+static void stat_print(void);
+static void transport_print(void);
+#ifdef LV_DEMO_BENCHMARK_STORE_PATH
+static uint32_t store_load(void);
+static void store_save(uint32_t run_cnt, uint32_t fps_weighted);
+static void regress_print(uint32_t fps_weighted);
+#endif
+static bool scene_regressed(uint32_t i, bool opa);
+static void table_draw_part_cb(lv_event_t * e);
+static void scene_start(void);
+static bool scene_selected(const scene_dsc_t * s);
+static void scenes_reset(void);
+static void sweep_apply(void);
+static void sweep_print(void);
+static void hist_reset(void);
+static void hist_store(frame_stat_t * stat);
+static uint16_t hist_percentile(uint32_t pct);
+#if LV_DEMO_BENCHMARK_VERIFY
+static void verify_run(void);
+static const golden_dsc_t * golden_find(const char * name);
+static uint32_t golden_cnt(void);
+#ifdef LV_DEMO_BENCHMARK_GOLDEN_PATH
+static void golden_save(void);
+#endif
+#endif
+static uint32_t crc32_update(uint32_t crc, const void * data, uint32_t len);
 static void scene_next_task_cb(lv_timer_t * timer);
 static void rect_create(lv_style_t * style);
 static void img_create(lv_style_t * style, const void * src, bool rotate, bool zoom, bool aa);
 static void txt_create(lv_style_t * style);
 static void line_create(lv_style_t * style);
 static void arc_create(lv_style_t * style);
+static lv_obj_t * transport_cont_create(void);
+static lv_obj_t * transport_rect_create(lv_obj_t * parent, lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h);
+static void transport_recolor_anim(lv_obj_t * cont);
+static void transport_recolor_anim_cb(void * var, int32_t v);
+static void transport_scroll_anim_cb(void * var, int32_t v);
 static void fall_anim(lv_obj_t * obj);
 static void rnd_reset(void);
 static int32_t rnd_next(int32_t min, int32_t max);
@@ -428,7 +597,7 @@ static void txt_large_compr_cb(void)
 static void line_cb(void)
 {
     lv_style_reset(&style_common);
-    lv_style_set_line_width(&style_common, LINE_WIDTH);
+    lv_style_set_line_width(&style_common, SCALE(LINE_WIDTH));
     lv_style_set_line_opa(&style_common, opa_mode ? LV_OPA_50 : LV_OPA_COVER);
     line_create(&style_common);
 
@@ -438,7 +607,7 @@ static void arc_think_cb(void)
 {
 
     lv_style_reset(&style_common);
-    lv_style_set_arc_width(&style_common, ARC_WIDTH_THIN);
+    lv_style_set_arc_width(&style_common, SCALE(ARC_WIDTH_THIN));
     lv_style_set_arc_opa(&style_common, opa_mode ? LV_OPA_50 : LV_OPA_COVER);
     arc_create(&style_common);
 }
@@ -446,7 +615,7 @@ static void arc_think_cb(void)
 static void arc_thick_cb(void)
 {
     lv_style_reset(&style_common);
-    lv_style_set_arc_width(&style_common, ARC_WIDTH_THICK);
+    lv_style_set_arc_width(&style_common, SCALE(ARC_WIDTH_THICK));
     lv_style_set_arc_opa(&style_common, opa_mode ? LV_OPA_50 : LV_OPA_COVER);
     arc_create(&style_common);
 
@@ -497,7 +666,7 @@ static void sub_img_cb(void)
 static void sub_line_cb(void)
 {
     lv_style_reset(&style_common);
-    lv_style_set_line_width(&style_common, LINE_WIDTH);
+    lv_style_set_line_width(&style_common, SCALE(LINE_WIDTH));
     lv_style_set_line_opa(&style_common, opa_mode ? LV_OPA_50 : LV_OPA_COVER);
     lv_style_set_blend_mode(&style_common, LV_BLEND_MODE_SUBTRACTIVE);
     line_create(&style_common);
@@ -507,7 +676,7 @@ static void sub_line_cb(void)
 static void sub_arc_cb(void)
 {
     lv_style_reset(&style_common);
-    lv_style_set_arc_width(&style_common, ARC_WIDTH_THICK);
+    lv_style_set_arc_width(&style_common, SCALE(ARC_WIDTH_THICK));
     lv_style_set_arc_opa(&style_common, opa_mode ? LV_OPA_50 : LV_OPA_COVER);
     lv_style_set_blend_mode(&style_common, LV_BLEND_MODE_SUBTRACTIVE);
     arc_create(&style_common);
@@ -522,6 +691,64 @@ static void sub_text_cb(void)
     txt_create(&style_common);
 }
 
+static void flush_full_cb(void)
+{
+    lv_obj_t * cont = transport_cont_create();
+    transport_rect_create(cont, 0, 0, lv_obj_get_width(scene_bg), lv_obj_get_height(scene_bg));
+    transport_recolor_anim(cont);
+}
+
+static void flush_tiny_cb(void)
+{
+    lv_obj_t * cont = transport_cont_create();
+    uint32_t cols = LV_MAX(lv_obj_get_width(scene_bg) / TINY_PITCH, 1);
+    uint32_t cells = cols * LV_MAX(lv_obj_get_height(scene_bg) / TINY_PITCH, 1);
+    uint32_t step = LV_MAX(cells / TINY_NUM, 1);
+
+    /*Spread over the whole area, far enough from each other not to be joined*/
+    uint32_t i;
+    for(i = 0; i < TINY_NUM && i * step < cells; i++) {
+        uint32_t c = i * step;
+        transport_rect_create(cont, (c % cols) * TINY_PITCH, (c / cols) * TINY_PITCH, TINY_SIZE, TINY_SIZE);
+    }
+    transport_recolor_anim(cont);
+}
+
+static void flush_scroll_cb(void)
+{
+    lv_obj_t * cont = transport_cont_create();
+    lv_coord_t w = lv_obj_get_width(scene_bg);
+    lv_coord_t h = lv_obj_get_height(scene_bg);
+
+    uint32_t i;
+    for(i = 0; i < SCROLL_STRIPE_NUM; i++) {
+        transport_rect_create(cont, 0, i * (h / 4), w, h / 8);
+    }
+
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_var(&a, cont);
+    lv_anim_set_exec_cb(&a, transport_scroll_anim_cb);
+    lv_anim_set_values(&a, 0, SCROLL_STRIPE_NUM * (h / 4) - h);
+    lv_anim_set_time(&a, SCENE_TIME / 2);
+    lv_anim_set_playback_time(&a, SCENE_TIME / 2);
+    lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE);
+    lv_anim_start(&a);
+}
+
+static void flush_strips_cb(void)
+{
+    lv_obj_t * cont = transport_cont_create();
+    lv_coord_t w = lv_obj_get_width(scene_bg);
+    lv_coord_t h = lv_obj_get_height(scene_bg);
+
+    uint32_t i;
+    for(i = 0; i < STRIP_NUM; i++) {
+        lv_coord_t sw = rnd_next(w / 4, w / 2);
+        transport_rect_create(cont, rnd_next(0, w - sw), i * (h / STRIP_NUM), sw, LV_MAX(h / STRIP_NUM / 2, 1));
+    }
+    transport_recolor_anim(cont);
+}
 
 
 /**********************
@@ -586,6 +813,11 @@ static scene_dsc_t scenes[] = {
         {.name = "Substr. arc",                .weight = 10, .create_cb = sub_arc_cb},
         {.name = "Substr. text",               .weight = 10, .create_cb = sub_text_cb},
 
+        {.name = "Flush full screen",          .transport = true, .create_cb = flush_full_cb},
+        {.name = "Flush 4x4 areas",            .transport = true, .create_cb = flush_tiny_cb},
+        {.name = "Flush vertical scroll",      .transport = true, .create_cb = flush_scroll_cb},
+        {.name = "Flush horizontal strips",    .transport = true, .create_cb = flush_strips_cb},
+
         {.name = "", .create_cb = NULL}
 };
 
@@ -595,6 +827,48 @@ static lv_obj_t * title;
 static lv_obj_t * subtitle;
 static uint32_t rnd_act;
 
+/*The display callbacks wrapped to split a refresh into rendering and flushing*/
+static void (*monitor_cb_orig)(lv_disp_drv_t * drv, uint32_t time, uint32_t px);
+static void (*flush_cb_orig)(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_p);
+static void (*wait_cb_orig)(lv_disp_drv_t * drv);
+static uint32_t refr_flush_us;
+static uint32_t refr_wait_us;
+static bool refr_monitored;
+
+/*Refresh times of the scene that is running*/
+static uint16_t hist[HIST_SIZE];
+static uint32_t hist_cnt;
+static uint32_t hist_min;
+static uint32_t hist_max;
+static uint32_t scene_start_tick;
+static uint32_t repeat_act;
+
+/*Verification: CRC32 of the flushed areas of the scene being rendered*/
+static bool verifying;
+static uint32_t verify_crc;
+
+/*Parameter sweep: every selected scene runs once per step*/
+static const lv_demo_benchmark_step_t * sweep_steps;
+static uint32_t sweep_step_cnt;
+static uint32_t sweep_step_act;
+static const char * sweep_filter;
+
+static finished_cb_t * finished_cb;
+static const char * fw_version = "";
+static const char * bench_target = "";
+#ifdef LV_DEMO_BENCHMARK_STORE_PATH
+/*The run before this one, if it had the same scenes*/
+static store_hdr_t baseline_hdr;
+static store_scene_t baseline[SCENE_CNT];
+static bool baseline_valid;
+#endif
+
+#if LV_DEMO_BENCHMARK_VERIFY
+static const golden_dsc_t golden[] = {
+#include "lv_demo_benchmark_golden.h"
+        {.name = NULL}
+};
+#endif
 
 static uint32_t rnd_map[] = {
         0xbd13204f, 0x67d8167f, 0x20211c99, 0xb0a7cc05,
@@ -626,8 +900,15 @@ static uint32_t rnd_map[] = {
 void lv_demo_benchmark(void)
 {
     lv_disp_t * disp = lv_disp_get_next(NULL);
+    monitor_cb_orig = disp->driver->monitor_cb;
     disp->driver->monitor_cb = monitor_cb;
 
+    flush_cb_orig = disp->driver->flush_cb;
+    wait_cb_orig = disp->driver->wait_cb;
+    disp->driver->flush_cb = flush_cb;
+    disp->driver->wait_cb = wait_cb;
+    disp->refr_timer->timer_cb = refr_timer_cb;
+
     lv_obj_t * scr = lv_scr_act();
     lv_obj_remove_style_all(scr);
     lv_obj_set_style_bg_opa(scr, LV_OPA_COVER, 0);
@@ -647,34 +928,686 @@ void lv_demo_benchmark(void)
 
     lv_obj_update_layout(scr);
 
+#if LV_DEMO_BENCHMARK_VERIFY
+    verify_run();
+#endif
+
     /*Manually start scenes*/
     scene_next_task_cb(NULL);
 }
 
+void lv_demo_benchmark_sweep(const lv_demo_benchmark_step_t * steps, uint32_t step_cnt, const char * filter)
+{
+    sweep_steps = step_cnt ? steps : NULL;
+    sweep_step_cnt = step_cnt;
+    sweep_step_act = 0;
+    sweep_filter = filter;
+    sweep_apply();
+
+    lv_demo_benchmark();
+}
+
+void lv_demo_benchmark_set_finished_cb(finished_cb_t * cb)
+{
+    finished_cb = cb;
+}
+
+void lv_demo_benchmark_set_version(const char * version)
+{
+    fw_version = version ? version : "";
+}
+
+void lv_demo_benchmark_set_target(const char * target)
+{
+    bench_target = target ? target : "";
+}
+
+bool lv_demo_benchmark_tick_held(void)
+{
+    return verifying;
+}
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 
 static void monitor_cb(lv_disp_drv_t * drv, uint32_t time, uint32_t px)
 {
-    LV_UNUSED(drv);
-    LV_UNUSED(px);
+    /*Keep the application's monitor, e.g. telemetry, running during the benchmark*/
+    if(monitor_cb_orig) monitor_cb_orig(drv, time, px);
+
+    if(verifying) return;
+
+    /*Let caches and the first full redraw of the scene settle*/
+    if(lv_tick_elapsed(scene_start_tick) < LV_DEMO_BENCHMARK_WARMUP_MS) return;
+
+    hist[LV_MIN(time, HIST_SIZE - 1)]++;
+    hist_cnt++;
+    hist_min = LV_MIN(hist_min, time);
+    hist_max = LV_MAX(hist_max, time);
+
     if(opa_mode) {
         scenes[scene_act].refr_cnt_opa ++;
         scenes[scene_act].time_sum_opa += time;
+        scenes[scene_act].px_opa += px;
     } else {
         scenes[scene_act].refr_cnt_normal ++;
         scenes[scene_act].time_sum_normal += time;
+        scenes[scene_act].px_normal += px;
     }
+    refr_monitored = true;
 
 //    lv_obj_invalidate(lv_scr_act());
 }
 
+/*Split a refresh into rendering, waiting for SPI and the fixed cost of the flushes.
+ *Without the driver's cycle counters all of flush_cb counts as overhead.*/
+static void refr_timer_cb(lv_timer_t * timer)
+{
+    uint32_t flush_cnt = 0;
+    uint32_t bytes = 0;
+    uint32_t sync_us = 0;
+    uint32_t ovh_us;
+
+    refr_flush_us = 0;
+    refr_wait_us = 0;
+    refr_monitored = false;
+
+#if FLUSH_STATS
+    lvgl_flush_stats_t start;
+    lvgl_flush_stats_t end;
+    lvgl_get_flush_stats(&start);
+#endif
+
+    uint32_t t = time_us();
+    _lv_disp_refr_timer(timer);
+    t = time_us() - t;
+
+    /*Only refreshes that drew something count, like in monitor_cb*/
+    if(!refr_monitored || scene_act < 0 || scenes[scene_act].create_cb == NULL) return;
+
+#if FLUSH_STATS
+    lvgl_get_flush_stats(&end);
+    flush_cnt = end.uiFlushes - start.uiFlushes;
+    bytes = (end.uiSyncBytes - start.uiSyncBytes) + (end.uiAsyncBytes - start.uiAsyncBytes);
+    /*Blocking transmits inside the flush are SPI time, not overhead*/
+    sync_us = (uint32_t)((end.ullSyncCycles - start.ullSyncCycles) / LVGL_CYCLES_PER_US);
+    ovh_us = (uint32_t)((end.ullFlushCycles - start.ullFlushCycles) / LVGL_CYCLES_PER_US);
+    ovh_us = ovh_us > sync_us ? ovh_us - sync_us : 0;
+#else
+    ovh_us = refr_flush_us;
+#endif
+
+    uint32_t flush_us = refr_flush_us + refr_wait_us;
+    uint32_t render_us = t > flush_us ? t - flush_us : 0;
+    if(opa_mode) {
+        scenes[scene_act].render_us_opa += render_us;
+        scenes[scene_act].spi_us_opa += refr_wait_us + sync_us;
+        scenes[scene_act].ovh_us_opa += ovh_us;
+        scenes[scene_act].flush_cnt_opa += flush_cnt;
+        scenes[scene_act].bytes_opa += bytes;
+    } else {
+        scenes[scene_act].render_us_normal += render_us;
+        scenes[scene_act].spi_us_normal += refr_wait_us + sync_us;
+        scenes[scene_act].ovh_us_normal += ovh_us;
+        scenes[scene_act].flush_cnt_normal += flush_cnt;
+        scenes[scene_act].bytes_normal += bytes;
+    }
+}
+
+static void flush_cb(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_p)
+{
+    if(verifying) {
+        /*The position is part of the result, the same pixels elsewhere are a different frame*/
+        lv_coord_t coords[4] = {area->x1, area->y1, area->x2, area->y2};
+        verify_crc = crc32_update(verify_crc, coords, sizeof(coords));
+        verify_crc = crc32_update(verify_crc, color_p, lv_area_get_size(area) * sizeof(lv_color_t));
+    }
+
+    uint32_t t = time_us();
+#if LV_DEMO_BENCHMARK_VIRTUAL_DISP
+    LV_UNUSED(area);
+    LV_UNUSED(color_p);
+    lv_disp_flush_ready(drv);
+#else
+    flush_cb_orig(drv, area, color_p);
+#endif
+    refr_flush_us += time_us() - t;
+}
+
+/*Called while the draw buffer is still being flushed, i.e. rendering waits for the display*/
+static void wait_cb(lv_disp_drv_t * drv)
+{
+    uint32_t t = time_us();
+    if(wait_cb_orig) wait_cb_orig(drv);
+    refr_wait_us += time_us() - t;
+}
+
+#if LV_DEMO_BENCHMARK_VERIFY
+/*Render LV_DEMO_BENCHMARK_VERIFY_FRAMES frames of every scene with a simulated tick and compare
+ *their CRC against the golden table. Animations only see the simulated time and rnd_reset() makes
+ *the objects the same, so a scene renders the same pixels on every run.*/
+static void verify_run(void)
+{
+    lv_disp_t * disp = lv_disp_get_next(NULL);
+    uint32_t mismatch = 0;
+    uint32_t i;
+
+    verifying = true;
+    TICK_HOLD(true);
+    printf("verify: %d frames, %d ms each\n", LV_DEMO_BENCHMARK_VERIFY_FRAMES, LV_DEMO_BENCHMARK_VERIFY_FRAME_MS);
+
+    for(i = 0; scenes[i].create_cb; i++) {
+        const golden_dsc_t * g = golden_find(scenes[i].name);
+        uint32_t opa;
+
+        scene_act = i;
+        for(opa = 0; opa < 2; opa++) {
+            opa_mode = opa;
+            lv_obj_clean(scene_bg);
+            lv_refr_now(disp);
+
+            /*Anims started from here on count time from this point*/
+            lv_anim_refr_now();
+            rnd_reset();
+            scenes[i].create_cb();
+
+            verify_crc = 0xFFFFFFFF;
+            uint32_t f;
+            for(f = 0; f < LV_DEMO_BENCHMARK_VERIFY_FRAMES; f++) {
+                TICK_INC(LV_DEMO_BENCHMARK_VERIFY_FRAME_MS);
+                lv_refr_now(disp);
+            }
+            if(opa) scenes[i].crc_opa = ~verify_crc;
+            else scenes[i].crc_normal = ~verify_crc;
+        }
+
+        uint32_t crc_normal = scenes[i].crc_normal;
+        uint32_t crc_opa = scenes[i].crc_opa;
+        const char * res_normal = g == NULL ? "NEW" : (g->crc_normal == crc_normal ? "ok" : "MISMATCH");
+        const char * res_opa = g == NULL ? "NEW" : (g->crc_opa == crc_opa ? "ok" : "MISMATCH");
+        if(g && (g->crc_normal != crc_normal || g->crc_opa != crc_opa)) mismatch++;
+
+        printf("verify: %-32.32s 0x%08"LV_PRIx32" %-8s 0x%08"LV_PRIx32" %s\n", scenes[i].name, crc_normal, res_normal, crc_opa, res_opa);
+    }
+
+    /*Nothing compared is not a pass, the goldens of this target were never taken*/
+    if(golden_cnt() == 0) {
+        LV_LOG_ERROR("no goldens of target \"%s\"", bench_target);
+        printf("verify: FAILED, lv_demo_benchmark_golden.h has no entry of target \"%s\"\n", bench_target);
+    }
+    else if(mismatch) {
+        LV_LOG_ERROR("%"LV_PRIu32" scene(s) mismatch", mismatch);
+        printf("verify: FAILED, %"LV_PRIu32" scene(s) mismatch\n", mismatch);
+    }
+    else {
+        printf("verify: passed\n");
+    }
+
+    /*Ready to paste into lv_demo_benchmark_golden.h*/
+    printf("verify: golden table of this build:\n");
+    for(i = 0; scenes[i].create_cb; i++) {
+        printf("        {\"%s\", \"%s\", 0x%08"LV_PRIx32", 0x%08"LV_PRIx32"},\n", bench_target,
+               scenes[i].name, scenes[i].crc_normal, scenes[i].crc_opa);
+    }
+#ifdef LV_DEMO_BENCHMARK_GOLDEN_PATH
+    golden_save();
+#endif
+
+    lv_obj_clean(scene_bg);
+    scene_act = -1;
+    opa_mode = true;
+    TICK_HOLD(false);
+    verifying = false;
+}
+
+static const golden_dsc_t * golden_find(const char * name)
+{
+    uint32_t i;
+    for(i = 0; golden[i].name; i++) {
+        if(strcmp(golden[i].target, bench_target) == 0 && strcmp(golden[i].name, name) == 0) return &golden[i];
+    }
+    return NULL;
+}
+
+/*Entries of the target this build runs on*/
+static uint32_t golden_cnt(void)
+{
+    uint32_t cnt = 0;
+    uint32_t i;
+    for(i = 0; golden[i].name; i++) {
+        if(strcmp(golden[i].target, bench_target) == 0) cnt++;
+    }
+    return cnt;
+}
+
+#ifdef LV_DEMO_BENCHMARK_GOLDEN_PATH
+/*lv_demo_benchmark_golden.h with the entries of this target replaced by the ones of this build,
+ *the other targets are kept. To copy over the old one*/
+static void golden_save(void)
+{
+    FILE * f = fopen(LV_DEMO_BENCHMARK_GOLDEN_PATH, "w");
+    if(f == NULL) {
+        LV_LOG_WARN("can't open %s", LV_DEMO_BENCHMARK_GOLDEN_PATH);
+        return;
+    }
+
+    fprintf(f, "/**\n"
+               " * @file lv_demo_benchmark_golden.h\n"
+               " *\n"
+               " * Golden CRC32 of every benchmark scene for LV_DEMO_BENCHMARK_VERIFY.\n"
+               " * Included inside the golden table of lv_demo_benchmark.c. An entry is\n"
+               " * keyed by the target given to lv_demo_benchmark_set_target(), the\n"
+               " * panel name on the board and in host/bench_lvgl, so one table holds\n"
+               " * the goldens of every panel. The values only hold for the resolution,\n"
+               " * color format and LVGL version they were taken with, a scene without\n"
+               " * an entry reports NEW. The verification fails while the table has no\n"
+               " * entry of the target. host/bench_lvgl -p <panel> writes this file\n"
+               " * with the entries of that panel replaced into its working directory.\n"
+               " *\n"
+               " * Format: {\"target\", \"scene name\", crc_normal, crc_opa},\n"
+               " */\n");
+    uint32_t i;
+    for(i = 0; golden[i].name; i++) {
+        if(strcmp(golden[i].target, bench_target) == 0) continue;
+        fprintf(f, "        {\"%s\", \"%s\", 0x%08"LV_PRIx32", 0x%08"LV_PRIx32"},\n", golden[i].target,
+                golden[i].name, golden[i].crc_normal, golden[i].crc_opa);
+    }
+    for(i = 0; scenes[i].create_cb; i++) {
+        fprintf(f, "        {\"%s\", \"%s\", 0x%08"LV_PRIx32", 0x%08"LV_PRIx32"},\n", bench_target,
+                scenes[i].name, scenes[i].crc_normal, scenes[i].crc_opa);
+    }
+
+    if(fclose(f) != 0) LV_LOG_WARN("can't write %s", LV_DEMO_BENCHMARK_GOLDEN_PATH);
+    else printf("verify: golden table written to %s\n", LV_DEMO_BENCHMARK_GOLDEN_PATH);
+}
+#endif
+#endif
+
+/*CRC-32 (IEEE 802.3), nibble table to keep it small*/
+static uint32_t crc32_update(uint32_t crc, const void * data, uint32_t len)
+{
+    static const uint32_t crc_tbl[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    const uint8_t * p = data;
+
+    while(len--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ crc_tbl[crc & 0x0F];
+        crc = (crc >> 4) ^ crc_tbl[crc & 0x0F];
+    }
+    return crc;
+}
+
+static void scene_start(void)
+{
+    rnd_reset();
+    scenes[scene_act].create_cb();
+    scene_start_tick = lv_tick_get();
+    lv_timer_t * t = lv_timer_create(scene_next_task_cb, LV_DEMO_BENCHMARK_WARMUP_MS + SCENE_TIME, NULL);
+    lv_timer_set_repeat_count(t, 1);
+}
+
+static void hist_reset(void)
+{
+    lv_memset_00(hist, sizeof(hist));
+    hist_cnt = 0;
+    hist_min = UINT32_MAX;
+    hist_max = 0;
+}
+
+static void hist_store(frame_stat_t * stat)
+{
+    if(hist_cnt == 0) {
+        lv_memset_00(stat, sizeof(frame_stat_t));
+        return;
+    }
+
+    stat->min = hist_min;
+    stat->p50 = hist_percentile(50);
+    stat->p95 = hist_percentile(95);
+    stat->p99 = hist_percentile(99);
+    stat->max = hist_max;
+}
+
+/*Smallest refresh time that pct percent of the refreshes did not exceed*/
+static uint16_t hist_percentile(uint32_t pct)
+{
+    uint32_t rank = (hist_cnt * pct + 99) / 100;
+    uint32_t sum = 0;
+    uint32_t i;
+    for(i = 0; i < HIST_SIZE - 1; i++) {
+        sum += hist[i];
+        if(sum >= rank) return i;
+    }
+
+    /*In the overflow bucket, the max is the best known bound*/
+    return hist_max;
+}
+
+/*Compact table of the refresh time distributions*/
+static void stat_print(void)
+{
+    uint32_t i;
+    printf("%-32s %4s %5s %4s %4s %4s %4s %4s %5s %5s %7s\n", "scene [ms]", "opa", "cnt", "min", "p50", "p95", "p99", "max",
+           "rnd%", "spi%", "us/flsh");
+    for(i = 0; scenes[i].create_cb; i++) {
+        uint32_t opa;
+        for(opa = 0; opa < 2; opa++) {
+            const scene_dsc_t * s = &scenes[i];
+            const frame_stat_t * st = opa ? &s->stat_opa : &s->stat_normal;
+            uint32_t render_us = opa ? s->render_us_opa : s->render_us_normal;
+            uint32_t spi_us = opa ? s->spi_us_opa : s->spi_us_normal;
+            uint32_t ovh_us = opa ? s->ovh_us_opa : s->ovh_us_normal;
+            uint32_t flush_cnt = opa ? s->flush_cnt_opa : s->flush_cnt_normal;
+            uint32_t sum_us = LV_MAX(render_us + spi_us + ovh_us, 1);
+
+            printf("%-32.32s %4"LV_PRIu32" %5"LV_PRIu32" %4u %4u %4u %4u %4u %5"LV_PRIu32" %5"LV_PRIu32" %7"LV_PRIu32"\n",
+                   s->name, opa, opa ? s->refr_cnt_opa : s->refr_cnt_normal,
+                   st->min, st->p50, st->p95, st->p99, st->max,
+                   (uint32_t)(((uint64_t)render_us * 100) / sum_us), (uint32_t)(((uint64_t)spi_us * 100) / sum_us),
+                   flush_cnt ? ovh_us / flush_cnt : 0);
+        }
+    }
+}
+
+static bool scene_selected(const scene_dsc_t * s)
+{
+    return sweep_filter == NULL || strstr(s->name, sweep_filter) != NULL;
+}
+
+/*Clear the results but keep the scene list itself*/
+static void scenes_reset(void)
+{
+    uint32_t i;
+    for(i = 0; scenes[i].create_cb; i++) {
+        scene_dsc_t * s = &scenes[i];
+        const char * name = s->name;
+        void (*create_cb)(void) = s->create_cb;
+        uint8_t weight = s->weight;
+        bool transport = s->transport;
+
+        lv_memset_00(s, sizeof(scene_dsc_t));
+        s->name = name;
+        s->create_cb = create_cb;
+        s->weight = weight;
+        s->transport = transport;
+    }
+}
+
+/*0 in a step means the default of that parameter*/
+static void sweep_apply(void)
+{
+    if(sweep_steps == NULL) return;
+
+    const lv_demo_benchmark_step_t * step = &sweep_steps[sweep_step_act];
+    obj_num = step->obj_num ? step->obj_num : OBJ_NUM;
+    img_num = step->img_num ? step->img_num : IMG_NUM;
+    size_pct = step->size_pct ? step->size_pct : 100;
+}
+
+/*One CSV line per selected scene of the step just finished*/
+static void sweep_print(void)
+{
+    uint32_t i;
+    if(sweep_step_act == 0) printf("sweep,step,obj_num,img_num,size_pct,scene,fps,fps_opa,bytes,bytes_opa\n");
+    for(i = 0; scenes[i].create_cb; i++) {
+        const scene_dsc_t * s = &scenes[i];
+        if(!scene_selected(s)) continue;
+#if FLUSH_STATS
+        uint32_t bytes_normal = s->bytes_normal;
+        uint32_t bytes_opa = s->bytes_opa;
+#else
+        uint32_t bytes_normal = s->px_normal * sizeof(lv_color_t);
+        uint32_t bytes_opa = s->px_opa * sizeof(lv_color_t);
+#endif
+        printf("sweep,%"LV_PRIu32",%"LV_PRIu32",%"LV_PRIu32",%"LV_PRIu32",\"%s\",%"LV_PRIu32",%"LV_PRIu32",%"LV_PRIu32",%"LV_PRIu32"\n",
+               sweep_step_act, obj_num, img_num, size_pct, s->name,
+               s->fps_normal, s->fps_opa, bytes_normal, bytes_opa);
+    }
+}
+
+/*Whether the transport scenes are limited by the bytes on the wire or by the cost of every flush*/
+static void transport_print(void)
+{
+    uint32_t i;
+    printf("%-32s %4s %6s %7s %7s %8s %8s  %s\n", "transport", "opa", "MB/s", "B/flsh", "us/flsh", "spi_ms", "ovh_ms",
+           "bound");
+    for(i = 0; scenes[i].create_cb; i++) {
+        if(!scenes[i].transport) continue;
+        uint32_t opa;
+        for(opa = 0; opa < 2; opa++) {
+            const scene_dsc_t * s = &scenes[i];
+            uint32_t time_ms = LV_MAX(opa ? s->time_sum_opa : s->time_sum_normal, 1);
+            uint32_t spi_us = opa ? s->spi_us_opa : s->spi_us_normal;
+            uint32_t ovh_us = opa ? s->ovh_us_opa : s->ovh_us_normal;
+            uint32_t flush_cnt = LV_MAX(opa ? s->flush_cnt_opa : s->flush_cnt_normal, 1);
+#if FLUSH_STATS
+            uint32_t bytes = opa ? s->bytes_opa : s->bytes_normal;
+#else
+            uint32_t bytes = (opa ? s->px_opa : s->px_normal) * sizeof(lv_color_t);
+#endif
+            /*Bytes per ms are kB/s*/
+            uint32_t kbps = bytes / time_ms;
+            const char * bound = "-";
+            if(spi_us || ovh_us) bound = ovh_us > spi_us ? "overhead" : "bandwidth";
+
+            printf("%-32.32s %4"LV_PRIu32" %3"LV_PRIu32".%02"LV_PRIu32" %7"LV_PRIu32" %7"LV_PRIu32" %8"LV_PRIu32" %8"LV_PRIu32"  %s\n",
+                   s->name, opa, kbps / 1000, (kbps % 1000) / 10, bytes / flush_cnt, ovh_us / flush_cnt,
+                   spi_us / 1000, ovh_us / 1000, bound);
+        }
+    }
+}
+
+#ifdef LV_DEMO_BENCHMARK_STORE_PATH
+static uint32_t scenes_crc(void)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    uint32_t i;
+    for(i = 0; i < SCENE_CNT; i++) {
+        crc = crc32_update(crc, scenes[i].name, strlen(scenes[i].name) + 1);
+    }
+    /*Without a target the runs stored before it existed still match*/
+    if(bench_target[0]) crc = crc32_update(crc, bench_target, strlen(bench_target) + 1);
+    return ~crc;
+}
+
+/*Read the runs stored so far, the last one becomes the baseline. Returns the number of runs*/
+static uint32_t store_load(void)
+{
+    baseline_valid = false;
+
+    FILE * f = fopen(LV_DEMO_BENCHMARK_STORE_PATH, "rb");
+    if(f == NULL) return 0;
+
+    uint32_t crc = scenes_crc();
+    uint32_t run_cnt = 0;
+    store_hdr_t hdr;
+    while(fread(&hdr, sizeof(hdr), 1, f) == 1 && hdr.magic == STORE_MAGIC) {
+        if(hdr.scene_cnt == SCENE_CNT && hdr.scenes_crc == crc) {
+            if(fread(baseline, sizeof(store_scene_t), SCENE_CNT, f) != SCENE_CNT) break;
+            baseline_hdr = hdr;
+            baseline_hdr.version[STORE_VERSION_LEN - 1] = '\0';
+            baseline_valid = true;
+        }
+        else {
+            if(fseek(f, hdr.scene_cnt * sizeof(store_scene_t), SEEK_CUR) != 0) break;
+            baseline_valid = false;
+        }
+        run_cnt++;
+    }
+
+    fclose(f);
+    return run_cnt;
+}
+
+/*Append this run, a full file starts over with the baseline in it*/
+static void store_save(uint32_t run_cnt, uint32_t fps_weighted)
+{
+    bool restart = run_cnt >= LV_DEMO_BENCHMARK_STORE_MAX;
+    FILE * f = fopen(LV_DEMO_BENCHMARK_STORE_PATH, restart ? "wb" : "ab");
+    if(f == NULL) {
+        LV_LOG_WARN("can't open %s", LV_DEMO_BENCHMARK_STORE_PATH);
+        return;
+    }
+
+    if(restart && baseline_valid) {
+        fwrite(&baseline_hdr, sizeof(baseline_hdr), 1, f);
+        fwrite(baseline, sizeof(store_scene_t), SCENE_CNT, f);
+    }
+
+    store_hdr_t hdr;
+    lv_memset_00(&hdr, sizeof(hdr));
+    hdr.magic = STORE_MAGIC;
+    hdr.scenes_crc = scenes_crc();
+    hdr.scene_cnt = SCENE_CNT;
+    hdr.fps_weighted = LV_MIN(fps_weighted, 0xFFFF);
+    strncpy(hdr.version, fw_version, STORE_VERSION_LEN - 1);
+    fwrite(&hdr, sizeof(hdr), 1, f);
+
+    uint32_t i;
+    for(i = 0; i < SCENE_CNT; i++) {
+        store_scene_t s;
+        s.fps_normal = LV_MIN(scenes[i].fps_normal, 0xFFFF);
+        s.fps_opa = LV_MIN(scenes[i].fps_opa, 0xFFFF);
+        fwrite(&s, sizeof(s), 1, f);
+    }
+
+    if(fclose(f) != 0) LV_LOG_WARN("can't write %s", LV_DEMO_BENCHMARK_STORE_PATH);
+}
+
+static void regress_print(uint32_t fps_weighted)
+{
+    if(!baseline_valid) {
+        printf("No baseline in %s\n", LV_DEMO_BENCHMARK_STORE_PATH);
+        return;
+    }
+
+    printf("Baseline \"%s\": weighted FPS %u -> %"LV_PRIu32"\n", baseline_hdr.version, baseline_hdr.fps_weighted,
+           fps_weighted);
+
+    uint32_t i;
+    for(i = 0; i < SCENE_CNT; i++) {
+        uint32_t opa;
+        for(opa = 0; opa < 2; opa++) {
+            uint32_t base = opa ? baseline[i].fps_opa : baseline[i].fps_normal;
+            uint32_t now = opa ? scenes[i].fps_opa : scenes[i].fps_normal;
+            if(scene_regressed(i, opa)) {
+                printf("REGRESSION %-32.32s %4"LV_PRIu32" %4"LV_PRIu32" -> %4"LV_PRIu32" FPS (-%"LV_PRIu32"%%)\n",
+                       scenes[i].name, opa, base, now, ((base - now) * 100) / base);
+            }
+#if LV_DEMO_BENCHMARK_DELTA
+            /*Scenes that did not run in one of the two have no FPS*/
+            else if(base && now) {
+                int32_t pct = (((int32_t)now - (int32_t)base) * 100) / (int32_t)base;
+                printf("DELTA      %-32.32s %4"LV_PRIu32" %4"LV_PRIu32" -> %4"LV_PRIu32" FPS (%+"LV_PRId32"%%)\n",
+                       scenes[i].name, opa, base, now, pct);
+            }
+#endif
+        }
+    }
+}
+#endif
+
+/*Slower than in the baseline by more than LV_DEMO_BENCHMARK_REGRESS_PCT*/
+static bool scene_regressed(uint32_t i, bool opa)
+{
+#ifdef LV_DEMO_BENCHMARK_STORE_PATH
+    if(!baseline_valid) return false;
+
+    uint32_t base = opa ? baseline[i].fps_opa : baseline[i].fps_normal;
+    uint32_t now = opa ? scenes[i].fps_opa : scenes[i].fps_normal;
+    return now * 100 < base * (100 - LV_DEMO_BENCHMARK_REGRESS_PCT);
+#else
+    LV_UNUSED(i);
+    LV_UNUSED(opa);
+    return false;
+#endif
+}
+
+/*Cells marked with LV_TABLE_CELL_CTRL_CUSTOM_1 are regressions*/
+static void table_draw_part_cb(lv_event_t * e)
+{
+    lv_obj_t * table = lv_event_get_target(e);
+    lv_obj_draw_part_dsc_t * dsc = lv_event_get_draw_part_dsc(e);
+    if(dsc->part != LV_PART_ITEMS) return;
+
+    uint16_t col_cnt = lv_table_get_col_cnt(table);
+    uint16_t row = dsc->id / col_cnt;
+    uint16_t col = dsc->id - row * col_cnt;
+    if(lv_table_has_cell_ctrl(table, row, col, LV_TABLE_CELL_CTRL_CUSTOM_1)) {
+        dsc->label_dsc->color = lv_palette_main(LV_PALETTE_RED);
+    }
+}
+
+static uint32_t time_us(void)
+{
+#ifdef ESP_PLATFORM
+    return (uint32_t)esp_timer_get_time();
+#else
+    return lv_tick_get() * 1000;
+#endif
+}
+
+/*One line per scene and mode, times are totals over the scene*/
+static void report_print(void)
+{
+#if LV_DEMO_BENCHMARK_REPORT != REPORT_NONE
+    uint32_t i;
+#if LV_DEMO_BENCHMARK_REPORT == REPORT_JSON
+    const char * fmt = "%s{\"scene\":\"%s\",\"opa\":%"LV_PRIu32",\"refr_cnt\":%"LV_PRIu32",\"time_ms\":%"LV_PRIu32
+                       ",\"render_us\":%"LV_PRIu32",\"spi_wait_us\":%"LV_PRIu32",\"flush_ovh_us\":%"LV_PRIu32
+                       ",\"flushes\":%"LV_PRIu32",\"bytes\":%"LV_PRIu32",\"px\":%"LV_PRIu32",\"fps\":%"LV_PRIu32"}\n";
+    printf("{\"virtual_disp\":%d,\"scene_time_ms\":%d,\"scenes\":[\n", LV_DEMO_BENCHMARK_VIRTUAL_DISP, SCENE_TIME);
+#else
+    const char * fmt = "%s\"%s\",%"LV_PRIu32",%"LV_PRIu32",%"LV_PRIu32",%"LV_PRIu32",%"LV_PRIu32",%"LV_PRIu32
+                       ",%"LV_PRIu32",%"LV_PRIu32",%"LV_PRIu32",%"LV_PRIu32"\n";
+    printf("scene,opa,refr_cnt,time_ms,render_us,spi_wait_us,flush_ovh_us,flushes,bytes,px,fps\n");
+#endif
+    for(i = 0; scenes[i].create_cb; i++) {
+        uint32_t opa;
+        for(opa = 0; opa < 2; opa++) {
+            const scene_dsc_t * s = &scenes[i];
+            printf(fmt,
+                   (LV_DEMO_BENCHMARK_REPORT == REPORT_JSON && (i || opa)) ? "," : "",
+                   s->name, opa,
+                   opa ? s->refr_cnt_opa : s->refr_cnt_normal,
+                   opa ? s->time_sum_opa : s->time_sum_normal,
+                   opa ? s->render_us_opa : s->render_us_normal,
+                   opa ? s->spi_us_opa : s->spi_us_normal,
+                   opa ? s->ovh_us_opa : s->ovh_us_normal,
+                   opa ? s->flush_cnt_opa : s->flush_cnt_normal,
+                   opa ? s->bytes_opa : s->bytes_normal,
+                   opa ? s->px_opa : s->px_normal,
+                   opa ? s->fps_opa : s->fps_normal);
+        }
+    }
+#if LV_DEMO_BENCHMARK_REPORT == REPORT_JSON
+    printf("]}\n");
+#endif
+#endif
+}
+
 static void scene_next_task_cb(lv_timer_t * timer)
 {
     LV_UNUSED(timer);
     lv_obj_clean(scene_bg);
 
+    /*Run the same scene again until it was repeated enough, the results add up*/
+    if(scene_act >= 0 && scenes[scene_act].create_cb && repeat_act + 1 < LV_DEMO_BENCHMARK_REPEAT) {
+        repeat_act++;
+        scene_start();
+        return;
+    }
+    repeat_act = 0;
+
+    if(scene_act >= 0 && scenes[scene_act].create_cb) {
+        hist_store(opa_mode ? &scenes[scene_act].stat_opa : &scenes[scene_act].stat_normal);
+    }
+    hist_reset();
+
     if(opa_mode) {
         if(scene_act >= 0) {
             if(scenes[scene_act].time_sum_opa == 0) scenes[scene_act].time_sum_opa = 1;
@@ -690,6 +1623,11 @@ static void scene_next_task_cb(lv_timer_t * timer)
         opa_mode = true;
     }
 
+    /*Scenes left out by the sweep's filter are skipped*/
+    if(!opa_mode) {
+        while(scenes[scene_act].create_cb && !scene_selected(&scenes[scene_act])) scene_act++;
+    }
+
     if(scenes[scene_act].create_cb) {
         lv_label_set_text_fmt(title, "%"LV_PRId32"/%d: %s%s", scene_act * 2 + (opa_mode ? 1 : 0), (sizeof(scenes) / sizeof(scene_dsc_t) * 2) - 2,  scenes[scene_act].name, opa_mode ? " + opa" : "");
         if(opa_mode) {
@@ -702,14 +1640,25 @@ static void scene_next_task_cb(lv_timer_t * timer)
             }
         }
 
-        rnd_reset();
-        scenes[scene_act].create_cb();
-        lv_timer_t * t = lv_timer_create(scene_next_task_cb, SCENE_TIME, NULL);
-        lv_timer_set_repeat_count(t, 1);
-
+        scene_start();
     }
     /*Ready*/
     else {
+        /*Sweep: report the step and run the scenes again with the next one*/
+        if(sweep_steps) {
+            sweep_print();
+            sweep_step_act++;
+            if(sweep_step_act < sweep_step_cnt) {
+                sweep_apply();
+                scenes_reset();
+                scene_act = -1;
+                opa_mode = true;
+                scene_next_task_cb(NULL);
+                return;
+            }
+            sweep_steps = NULL;
+        }
+
         uint32_t weight_sum = 0;
         uint32_t weight_normal_sum = 0;
         uint32_t weight_opa_sum = 0;
@@ -718,6 +1667,7 @@ static void scene_next_task_cb(lv_timer_t * timer)
         uint32_t fps_opa_sum = 0;
         uint32_t i;
         for(i = 0; scenes[i].create_cb; i++) {
+            if(scenes[i].transport) continue;
             fps_normal_sum += scenes[i].fps_normal * scenes[i].weight;
             weight_normal_sum += scenes[i].weight;
 
@@ -734,7 +1684,20 @@ static void scene_next_task_cb(lv_timer_t * timer)
         uint32_t fps_normal_unweighted = fps_normal_sum / weight_normal_sum;
         uint32_t fps_opa_unweighted = fps_opa_sum / weight_opa_sum;
 
-        uint32_t opa_speed_pct = (fps_opa_unweighted * 100) / fps_normal_unweighted;
+        uint32_t opa_speed_pct = (fps_opa_unweighted * 100) / LV_MAX(fps_normal_unweighted, 1);
+
+        stat_print();
+        transport_print();
+        report_print();
+
+#ifdef LV_DEMO_BENCHMARK_STORE_PATH
+        /*Sweeps run with other parameters, they are not a baseline*/
+        if(sweep_step_cnt == 0) {
+            uint32_t run_cnt = store_load();
+            regress_print(fps_weighted);
+            store_save(run_cnt, fps_weighted);
+        }
+#endif
 
         lv_obj_clean(lv_scr_act());
         scene_bg = NULL;
@@ -756,6 +1719,7 @@ static void scene_next_task_cb(lv_timer_t * timer)
         lv_table_set_col_width(table, 0, (w * 3) / 4 - 3);
         lv_table_set_col_width(table, 1, w  / 4 - 3);
         lv_obj_set_width(table, lv_pct(100));
+        lv_obj_add_event_cb(table, table_draw_part_cb, LV_EVENT_DRAW_PART_BEGIN, NULL);
 
 //        static lv_style_t style_cell_slow;
 //        static lv_style_t style_cell_very_slow;
@@ -777,11 +1741,43 @@ static void scene_next_task_cb(lv_timer_t * timer)
 
 
         uint16_t row = 0;
+        char buf[256];
+
+#ifdef LV_DEMO_BENCHMARK_STORE_PATH
+        /*Slower than the previous run, previous > now FPS*/
+        if(baseline_valid) {
+            lv_table_add_cell_ctrl(table, row, 0, LV_TABLE_CELL_CTRL_MERGE_RIGHT);
+            lv_snprintf(buf, sizeof(buf), "Regressions since %s", baseline_hdr.version);
+            lv_table_set_cell_value(table, row, 0, buf);
+            row++;
+            uint16_t first = row;
+            for(i = 0; i < SCENE_CNT; i++) {
+                uint32_t opa;
+                for(opa = 0; opa < 2; opa++) {
+                    if(!scene_regressed(i, opa)) continue;
+                    lv_snprintf(buf, sizeof(buf), "%s%s", scenes[i].name, opa ? " + opa" : "");
+                    lv_table_set_cell_value(table, row, 0, buf);
+                    lv_snprintf(buf, sizeof(buf), "%u>%"LV_PRIu32, opa ? baseline[i].fps_opa : baseline[i].fps_normal,
+                                opa ? scenes[i].fps_opa : scenes[i].fps_normal);
+                    lv_table_set_cell_value(table, row, 1, buf);
+                    lv_table_add_cell_ctrl(table, row, 0, LV_TABLE_CELL_CTRL_CUSTOM_1);
+                    lv_table_add_cell_ctrl(table, row, 1, LV_TABLE_CELL_CTRL_CUSTOM_1);
+                    row++;
+                }
+            }
+            if(row == first) {
+                lv_table_add_cell_ctrl(table, row, 0, LV_TABLE_CELL_CTRL_MERGE_RIGHT);
+                lv_table_set_cell_value(table, row, 0, "None");
+                row++;
+            }
+        }
+#endif
+
+        uint16_t slow_first = row;
         lv_table_add_cell_ctrl(table, row, 0, LV_TABLE_CELL_CTRL_MERGE_RIGHT);
         lv_table_set_cell_value(table, row, 0, "Slow but common cases");
 //        lv_table_set_cell_type(table, row, 0, 4);
         row++;
-        char buf[256];
         for(i = 0; i < sizeof(scenes) / sizeof(scene_dsc_t) - 1; i++) {
 
             if(scenes[i].fps_normal < 20 && scenes[i].weight >= 10) {
@@ -811,7 +1807,7 @@ static void scene_next_task_cb(lv_timer_t * timer)
         }
 
         /*No 'slow but common cases'*/
-        if(row == 1) {
+        if(row == slow_first + 1) {
             lv_table_add_cell_ctrl(table, row, 0, LV_TABLE_CELL_CTRL_MERGE_RIGHT);
             lv_table_set_cell_value(table, row, 0, "All good");
             row++;
@@ -827,6 +1823,7 @@ static void scene_next_task_cb(lv_timer_t * timer)
 
             lv_snprintf(buf, sizeof(buf), "%"LV_PRIu32, scenes[i].fps_normal);
             lv_table_set_cell_value(table, row, 1, buf);
+            if(scene_regressed(i, false)) lv_table_add_cell_ctrl(table, row, 1, LV_TABLE_CELL_CTRL_CUSTOM_1);
 
             if(scenes[i].fps_normal < 10) {
 //                lv_table_set_cell_type(table, row, 0, 3);
@@ -844,7 +1841,7 @@ static void scene_next_task_cb(lv_timer_t * timer)
 
             lv_snprintf(buf, sizeof(buf), "%"LV_PRIu32, scenes[i].fps_opa);
             lv_table_set_cell_value(table, row, 1, buf);
-
+            if(scene_regressed(i, true)) lv_table_add_cell_ctrl(table, row, 1, LV_TABLE_CELL_CTRL_CUSTOM_1);
 
             if(scenes[i].fps_opa < 10) {
 //                lv_table_set_cell_type(table, row, 0, 3);
@@ -860,6 +1857,7 @@ static void scene_next_task_cb(lv_timer_t * timer)
 
 //        lv_page_set_scrl_layout(page, LV_LAYOUT_COLUMN_LEFT);
 
+        if(finished_cb) finished_cb();
     }
 }
 
@@ -867,7 +1865,7 @@ static void scene_next_task_cb(lv_timer_t * timer)
 static void rect_create(lv_style_t * style)
 {
     uint32_t i;
-    for(i = 0; i < OBJ_NUM; i++) {
+    for(i = 0; i < obj_num; i++) {
         lv_obj_t * obj = lv_obj_create(scene_bg);
         lv_obj_remove_style_all(obj);
         lv_obj_add_style(obj, style, 0);
@@ -875,7 +1873,8 @@ static void rect_create(lv_style_t * style)
         lv_obj_set_style_border_color(obj, lv_color_hex(rnd_next(0, 0xFFFFF0)), 0);
         lv_obj_set_style_shadow_color(obj, lv_color_hex(rnd_next(0, 0xFFFFF0)), 0);
 
-        lv_obj_set_size(obj, rnd_next(OBJ_SIZE_MIN, OBJ_SIZE_MAX), rnd_next(OBJ_SIZE_MIN, OBJ_SIZE_MAX));
+        lv_obj_set_size(obj, rnd_next(SCALE(OBJ_SIZE_MIN), SCALE(OBJ_SIZE_MAX)),
+                        rnd_next(SCALE(OBJ_SIZE_MIN), SCALE(OBJ_SIZE_MAX)));
 
         fall_anim(obj);
     }
@@ -885,7 +1884,7 @@ static void rect_create(lv_style_t * style)
 static void img_create(lv_style_t * style, const void * src, bool rotate, bool zoom, bool aa)
 {
     uint32_t i;
-    for(i = 0; i < (uint32_t)IMG_NUM; i++) {
+    for(i = 0; i < img_num; i++) {
         lv_obj_t * obj = lv_img_create(scene_bg);
         lv_obj_remove_style_all(obj);
         lv_obj_add_style(obj, style, 0);
@@ -904,7 +1903,7 @@ static void img_create(lv_style_t * style, const void * src, bool rotate, bool z
 static void txt_create(lv_style_t * style)
 {
     uint32_t i;
-    for(i = 0; i < OBJ_NUM; i++) {
+    for(i = 0; i < obj_num; i++) {
         lv_obj_t * obj = lv_label_create(scene_bg);
         lv_obj_remove_style_all(obj);
         lv_obj_add_style(obj, style, 0);
@@ -921,14 +1920,18 @@ static void line_create(lv_style_t * style)
 {
     static lv_point_t points[OBJ_NUM][LINE_POINT_NUM];
 
+    /*A sweep with more than OBJ_NUM lines shares the point lists*/
     uint32_t i;
-    for(i = 0; i < OBJ_NUM; i++) {
-        points[i][0].x = 0;
-        points[i][0].y = 0;
-        uint32_t j;
-        for(j = 1; j < LINE_POINT_NUM; j++) {
-            points[i][j].x = points[i][j - 1].x + rnd_next(LINE_POINT_DIFF_MIN, LINE_POINT_DIFF_MAX);
-            points[i][j].y = rnd_next(LINE_POINT_DIFF_MIN, LINE_POINT_DIFF_MAX) ;
+    for(i = 0; i < obj_num; i++) {
+        lv_point_t * p = points[i % OBJ_NUM];
+        if(i < OBJ_NUM) {
+            p[0].x = 0;
+            p[0].y = 0;
+            uint32_t j;
+            for(j = 1; j < LINE_POINT_NUM; j++) {
+                p[j].x = p[j - 1].x + SCALE(rnd_next(LINE_POINT_DIFF_MIN, LINE_POINT_DIFF_MAX));
+                p[j].y = SCALE(rnd_next(LINE_POINT_DIFF_MIN, LINE_POINT_DIFF_MAX));
+            }
         }
 
 
@@ -937,7 +1940,7 @@ static void line_create(lv_style_t * style)
         lv_obj_add_style(obj, style, 0);
         lv_obj_set_style_line_color(obj, lv_color_hex(rnd_next(0, 0xFFFFF0)), 0);
 
-        lv_line_set_points(obj, points[i], LINE_POINT_NUM);
+        lv_line_set_points(obj, p, LINE_POINT_NUM);
 
         fall_anim(obj);
 
@@ -948,10 +1951,11 @@ static void line_create(lv_style_t * style)
 static void arc_create(lv_style_t * style)
 {
     uint32_t i;
-    for(i = 0; i < OBJ_NUM; i++) {
+    for(i = 0; i < obj_num; i++) {
         lv_obj_t * obj = lv_arc_create(scene_bg);
         lv_obj_remove_style_all(obj);
-        lv_obj_set_size(obj, rnd_next(OBJ_SIZE_MIN, OBJ_SIZE_MAX), rnd_next(OBJ_SIZE_MIN, OBJ_SIZE_MAX));
+        lv_obj_set_size(obj, rnd_next(SCALE(OBJ_SIZE_MIN), SCALE(OBJ_SIZE_MAX)),
+                        rnd_next(SCALE(OBJ_SIZE_MIN), SCALE(OBJ_SIZE_MAX)));
         lv_obj_add_style(obj, style, LV_PART_INDICATOR);
         lv_obj_set_style_arc_color(obj, lv_color_hex(rnd_next(0, 0xFFFFF0)), LV_PART_INDICATOR);
 
@@ -974,6 +1978,54 @@ static void arc_create(lv_style_t * style)
 }
 
 
+/*A full size holder of the scene, its children are recolored or scrolled every frame*/
+static lv_obj_t * transport_cont_create(void)
+{
+    lv_obj_t * cont = lv_obj_create(scene_bg);
+    lv_obj_remove_style_all(cont);
+    lv_obj_set_size(cont, lv_obj_get_width(scene_bg), lv_obj_get_height(scene_bg));
+    lv_obj_set_scrollbar_mode(cont, LV_SCROLLBAR_MODE_OFF);
+    return cont;
+}
+
+static lv_obj_t * transport_rect_create(lv_obj_t * parent, lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h)
+{
+    lv_obj_t * obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_set_style_bg_opa(obj, opa_mode ? LV_OPA_50 : LV_OPA_COVER, 0);
+    lv_obj_set_style_bg_color(obj, lv_color_hex(rnd_next(0, 0xFFFFF0)), 0);
+    lv_obj_set_pos(obj, x, y);
+    lv_obj_set_size(obj, w, h);
+    return obj;
+}
+
+static void transport_recolor_anim(lv_obj_t * cont)
+{
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_var(&a, cont);
+    lv_anim_set_exec_cb(&a, transport_recolor_anim_cb);
+    lv_anim_set_values(&a, 0, 255);
+    lv_anim_set_time(&a, SCENE_TIME);
+    lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE);
+    lv_anim_start(&a);
+}
+
+static void transport_recolor_anim_cb(void * var, int32_t v)
+{
+    uint32_t cnt = lv_obj_get_child_cnt(var);
+    uint32_t i;
+    for(i = 0; i < cnt; i++) {
+        lv_color_t c = lv_color_make((uint8_t)(v + i * 16), (uint8_t)(v * 3 + i * 32), (uint8_t)(255 - v));
+        lv_obj_set_style_bg_color(lv_obj_get_child(var, i), c, 0);
+    }
+}
+
+static void transport_scroll_anim_cb(void * var, int32_t v)
+{
+    lv_obj_scroll_to_y(var, v, LV_ANIM_OFF);
+}
+
 static void fall_anim(lv_obj_t * obj)
 {
     lv_obj_set_x(obj, rnd_next(0, lv_obj_get_width(scene_bg) - lv_obj_get_width(obj)));
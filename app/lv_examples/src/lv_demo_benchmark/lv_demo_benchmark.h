@@ -14,20 +14,84 @@ extern "C" {
  *      INCLUDES
  *********************/
 #include "../../lv_demo.h"
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
 
 /*********************
  *      DEFINES
  *********************/
+/*With CONFIG_LV_CONF_SKIP lv_conf.h is not read, the switches come from the
+ *"LVGL benchmark" menu of main/Kconfig.projbuild then. lv_conf.h wins if it is read.
+ *Here and not in the .c file, the application checks some of them too*/
+#if !defined(LV_DEMO_BENCHMARK_REPORT) && defined(CONFIG_LV_DEMO_BENCHMARK_REPORT)
+#define LV_DEMO_BENCHMARK_REPORT CONFIG_LV_DEMO_BENCHMARK_REPORT
+#endif
+#if !defined(LV_DEMO_BENCHMARK_VIRTUAL_DISP) && defined(CONFIG_LV_DEMO_BENCHMARK_VIRTUAL_DISP)
+#define LV_DEMO_BENCHMARK_VIRTUAL_DISP 1
+#endif
+#if !defined(LV_DEMO_BENCHMARK_WARMUP_MS) && defined(CONFIG_LV_DEMO_BENCHMARK_WARMUP_MS)
+#define LV_DEMO_BENCHMARK_WARMUP_MS CONFIG_LV_DEMO_BENCHMARK_WARMUP_MS
+#endif
+#if !defined(LV_DEMO_BENCHMARK_REPEAT) && defined(CONFIG_LV_DEMO_BENCHMARK_REPEAT)
+#define LV_DEMO_BENCHMARK_REPEAT CONFIG_LV_DEMO_BENCHMARK_REPEAT
+#endif
+#if !defined(LV_DEMO_BENCHMARK_VERIFY) && defined(CONFIG_LV_DEMO_BENCHMARK_VERIFY)
+#define LV_DEMO_BENCHMARK_VERIFY 1
+#define LV_DEMO_BENCHMARK_VERIFY_FRAMES CONFIG_LV_DEMO_BENCHMARK_VERIFY_FRAMES
+#define LV_DEMO_BENCHMARK_VERIFY_FRAME_MS CONFIG_LV_DEMO_BENCHMARK_VERIFY_FRAME_MS
+#endif
+#if !defined(LV_DEMO_BENCHMARK_TINY_NUM) && defined(CONFIG_LV_DEMO_BENCHMARK_TINY_NUM)
+#define LV_DEMO_BENCHMARK_TINY_NUM CONFIG_LV_DEMO_BENCHMARK_TINY_NUM
+#endif
+/*Commenting out the path in lv_conf.h disables the store, so only without lv_conf.h*/
+#if defined(CONFIG_LV_CONF_SKIP) && defined(CONFIG_LV_DEMO_BENCHMARK_STORE) && !defined(LV_DEMO_BENCHMARK_STORE_PATH)
+#define LV_DEMO_BENCHMARK_STORE_PATH CONFIG_LV_DEMO_BENCHMARK_STORE_PATH
+#define LV_DEMO_BENCHMARK_STORE_MAX CONFIG_LV_DEMO_BENCHMARK_STORE_MAX
+#define LV_DEMO_BENCHMARK_REGRESS_PCT CONFIG_LV_DEMO_BENCHMARK_REGRESS_PCT
+#endif
+#if !defined(LV_DEMO_BENCHMARK_DELTA) && defined(CONFIG_LV_DEMO_BENCHMARK_DELTA)
+#define LV_DEMO_BENCHMARK_DELTA 1
+#endif
 
 /**********************
  *      TYPEDEFS
  **********************/
 
+/*One step of a parameter sweep, 0 keeps the default of a field*/
+typedef struct {
+    uint16_t obj_num;       /*Rectangles, labels, lines and arcs per scene*/
+    uint16_t img_num;       /*Images per image scene*/
+    uint16_t size_pct;      /*Object sizes, line and arc widths in percent*/
+}lv_demo_benchmark_step_t;
+
+typedef void finished_cb_t(void);
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
 void lv_demo_benchmark(void);
 
+/*Run the scenes whose name contains `filter` (NULL: all) once per step
+ *and print the FPS and the bytes flushed of every step as CSV*/
+void lv_demo_benchmark_sweep(const lv_demo_benchmark_step_t * steps, uint32_t step_cnt, const char * filter);
+
+/*Called once all scenes ran and the results are printed and shown,
+ *e.g. for a headless run to stop*/
+void lv_demo_benchmark_set_finished_cb(finished_cb_t * finished_cb);
+
+/*Firmware version stored with the results in LV_DEMO_BENCHMARK_STORE_PATH,
+ *the string is not copied*/
+void lv_demo_benchmark_set_version(const char * version);
+
+/*Display backend the results are taken on, runs stored for another one
+ *are not compared with. The string is not copied*/
+void lv_demo_benchmark_set_target(const char * target);
+
+/*True while LV_DEMO_BENCHMARK_VERIFY drives the tick itself,
+ *the application's tick source must not call lv_tick_inc() meanwhile*/
+bool lv_demo_benchmark_tick_held(void);
+
 /**********************
  *      MACROS
  **********************/
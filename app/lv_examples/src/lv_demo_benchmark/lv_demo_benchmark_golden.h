@@ -0,0 +1,15 @@
+/**
+ * @file lv_demo_benchmark_golden.h
+ *
+ * Golden CRC32 of every benchmark scene for LV_DEMO_BENCHMARK_VERIFY.
+ * Included inside the golden table of lv_demo_benchmark.c. An entry is
+ * keyed by the target given to lv_demo_benchmark_set_target(), the
+ * panel name on the board and in host/bench_lvgl, so one table holds
+ * the goldens of every panel. The values only hold for the resolution,
+ * color format and LVGL version they were taken with, a scene without
+ * an entry reports NEW. The verification fails while the table has no
+ * entry of the target. host/bench_lvgl -p <panel> writes this file
+ * with the entries of that panel replaced into its working directory.
+ *
+ * Format: {"target", "scene name", crc_normal, crc_opa},
+ */
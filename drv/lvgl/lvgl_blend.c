@@ -0,0 +1,542 @@
+/**
+ * @file lvgl_blend.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "driver/soc.h"
+
+#include "lvgl_helpers.h"
+#include "lvgl_blend.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TAG "lvgl_blend"
+
+/* The kernels handle RGB565 into a plain draw buffer, anything else stays with LVGL */
+#define LVGL_BLEND_SUPPORTED        (LV_COLOR_DEPTH == 16 && LV_COLOR_SCREEN_TRANSP == 0)
+
+#define BLEND_BENCH_ROWS            (16)
+#define BLEND_BENCH_ROUNDS          (8)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef void (*lvgl_blend_cb_t)(lv_draw_ctx_t* ptCtx, const lv_draw_sw_blend_dsc_t* ptDsc);
+
+typedef struct
+{
+    const char* pcName;
+    uint32_t uiKernel;
+    lv_opa_t ucOpa;
+    bool bMask;
+} lvgl_blend_case_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+#if LVGL_BLEND_SUPPORTED
+static void lvgl_blend_cb(lv_draw_ctx_t* ptCtx, const lv_draw_sw_blend_dsc_t* ptDsc);
+static void lvgl_blend_fill(lv_color_t* ptDest, int32_t iW, int32_t iH, int32_t iStride, lv_color_t tColor);
+static void lvgl_blend_fill_opa(lv_color_t* ptDest, int32_t iW, int32_t iH, int32_t iStride, lv_color_t tColor,
+                                lv_opa_t ucOpa);
+static void lvgl_blend_mask(lv_color_t* ptDest, int32_t iW, int32_t iH, int32_t iStride, lv_color_t tColor,
+                            const lv_opa_t* pucMask, int32_t iMaskStride);
+static void lvgl_blend_mask_opa(lv_color_t* ptDest, int32_t iW, int32_t iH, int32_t iStride, lv_color_t tColor,
+                                lv_opa_t ucOpa, const lv_opa_t* pucMask, int32_t iMaskStride);
+static void lvgl_blend_pattern(lv_color_t* ptColors, lv_opa_t* pucMask, uint32_t uiPx);
+static uint32_t lvgl_blend_time(lv_draw_sw_ctx_t* ptCtx, const lv_draw_sw_blend_dsc_t* ptDsc, lv_color_t* ptBuf,
+                                const lv_color_t* ptPattern, uint32_t uiPx, lvgl_blend_cb_t pfnBlend);
+#endif
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static uint32_t s_uiKernels = LVGL_BLEND_ALL;
+
+#if LVGL_BLEND_SUPPORTED
+static const lvgl_blend_case_t s_atCases[] = {
+    {"fill",     LVGL_BLEND_FILL,     LV_OPA_COVER, false},
+    {"fill_opa", LVGL_BLEND_FILL_OPA, LV_OPA_50,    false},
+    {"mask",     LVGL_BLEND_MASK,     LV_OPA_COVER, true},
+    {"mask_opa", LVGL_BLEND_MASK_OPA, LV_OPA_50,    true},
+};
+#endif
+
+/**********************
+ *      MACROS
+ **********************/
+/* Two pixels in one word, the LX106 faults on unaligned word accesses so every kernel
+   handles a leading odd pixel before it goes word wise */
+#define PAIR(c)             ((uint32_t)(c) | ((uint32_t)(c) << 16))
+#define IS_ODD_PX(p)        (((uintptr_t)(p) & 0x2) != 0)
+
+/* The opacity fill of fill_normal() mixes with a premultiplied color when it can */
+#if LV_COLOR_MIX_ROUND_OFS == 0
+#define MIX_OPA(d)          lv_color_mix_premult(ausPremult, (d), ucOpaInv)
+#else
+#define MIX_OPA(d)          lv_color_mix(tColor, (d), ucOpa)
+#endif
+
+/* One pixel of the opacity fill: a run of equal destination colors is mixed once */
+#define FILL_OPA_PX(px)                                 \
+    if ((px).full != tLastDest.full)                    \
+    {                                                   \
+        tLastDest = (px);                               \
+        (px) = MIX_OPA(px);                             \
+        tLastRes = (px);                                \
+    }                                                   \
+    else                                                \
+    {                                                   \
+        (px) = tLastRes;                                \
+    }
+
+#define MASK_PX(px, m)                                  \
+    if ((m) == LV_OPA_COVER)                            \
+    {                                                   \
+        (px) = tColor;                                  \
+    }                                                   \
+    else if (m)                                         \
+    {                                                   \
+        (px) = lv_color_mix(tColor, (px), (m));         \
+    }
+
+/* One pixel of the masked opacity fill, the mix is redone when the mask or the destination changes */
+#define MASK_OPA_PX(px, m)                                                                  \
+    if (m)                                                                                  \
+    {                                                                                       \
+        if ((m) != ucLastMask)                                                              \
+        {                                                                                   \
+            ucOpaTmp = (m) == LV_OPA_COVER ? ucOpa : (lv_opa_t)(((uint32_t)(m) * ucOpa) >> 8); \
+        }                                                                                   \
+        if ((m) != ucLastMask || (px).full != tLastDest.full)                               \
+        {                                                                                   \
+            tLastRes = ucOpaTmp == LV_OPA_COVER ? tColor : lv_color_mix(tColor, (px), ucOpaTmp); \
+            ucLastMask = (m);                                                               \
+            tLastDest = (px);                                                               \
+        }                                                                                   \
+        (px) = tLastRes;                                                                    \
+    }
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lvgl_blend_ctx_init(lv_disp_drv_t* ptDrv, lv_draw_ctx_t* ptCtx)
+{
+    lv_draw_sw_init_ctx(ptDrv, ptCtx);
+#if LVGL_BLEND_SUPPORTED
+    ((lv_draw_sw_ctx_t*)ptCtx)->blend = lvgl_blend_cb;
+#endif
+}
+
+void lvgl_blend_set_kernels(uint32_t uiKernels)
+{
+    s_uiKernels = uiKernels & LVGL_BLEND_ALL;
+}
+
+uint32_t lvgl_blend_get_kernels(void)
+{
+    return s_uiKernels;
+}
+
+void lvgl_blend_benchmark(void)
+{
+#if LVGL_BLEND_SUPPORTED
+    const int32_t iW = LV_HOR_RES_MAX;
+    const int32_t iH = BLEND_BENCH_ROWS;
+    const uint32_t uiPx = iW * iH;
+
+    lv_color_t* ptPattern = (lv_color_t*)malloc(uiPx * sizeof(lv_color_t));
+    lv_color_t* ptRef = (lv_color_t*)malloc(uiPx * sizeof(lv_color_t));
+    lv_color_t* ptFast = (lv_color_t*)malloc(uiPx * sizeof(lv_color_t));
+    lv_opa_t* pucMask = (lv_opa_t*)malloc(uiPx);
+    if (ptPattern == NULL || ptRef == NULL || ptFast == NULL || pucMask == NULL)
+    {
+        ESP_LOGE(TAG, "malloc fail!!");
+        goto End_Func;
+    }
+    lvgl_blend_pattern(ptPattern, pucMask, uiPx);
+
+    /* lv_draw_sw_blend_basic() looks at the driver of the display being refreshed */
+    lv_disp_t* ptDispOld = _lv_refr_get_disp_refreshing();
+    _lv_refr_set_disp_refreshing(lv_disp_get_default());
+
+    lv_area_t tBufArea = {0, 0, iW - 1, iH - 1};
+    /* Odd start and width, so the unaligned heads and tails run too */
+    lv_area_t tBlendArea = {1, 0, iW - 3, iH - 1};
+    lv_draw_sw_ctx_t tCtx;
+    memset(&tCtx, 0, sizeof(tCtx));
+    tCtx.base_draw.buf_area = &tBufArea;
+    tCtx.base_draw.clip_area = &tBufArea;
+
+    uint32_t uiKernels = s_uiKernels;
+    s_uiKernels = LVGL_BLEND_ALL;
+
+    ESP_LOGI(TAG, "%-8s %8s %8s %7s %s", "kernel", "basic_us", "fast_us", "speedup", "exact");
+    for (uint32_t i = 0; i < sizeof(s_atCases) / sizeof(s_atCases[0]); i++)
+    {
+        const lvgl_blend_case_t* ptCase = &s_atCases[i];
+        lv_draw_sw_blend_dsc_t tDsc;
+
+        memset(&tDsc, 0, sizeof(tDsc));
+        tDsc.blend_area = &tBlendArea;
+        tDsc.color = lv_color_make(0x30, 0xC0, 0x60);
+        tDsc.opa = ptCase->ucOpa;
+        tDsc.blend_mode = LV_BLEND_MODE_NORMAL;
+        if (ptCase->bMask)
+        {
+            tDsc.mask_buf = pucMask;
+            tDsc.mask_area = &tBlendArea;
+            tDsc.mask_res = LV_DRAW_MASK_RES_CHANGED;
+        }
+
+        uint32_t uiRefUs = lvgl_blend_time(&tCtx, &tDsc, ptRef, ptPattern, uiPx, lv_draw_sw_blend_basic);
+        uint32_t uiFastUs = lvgl_blend_time(&tCtx, &tDsc, ptFast, ptPattern, uiPx, lvgl_blend_cb);
+        bool bExact = memcmp(ptRef, ptFast, uiPx * sizeof(lv_color_t)) == 0;
+        if (!bExact)
+        {
+            uiKernels &= ~ptCase->uiKernel;
+        }
+
+        uint32_t uiSpeedup = uiFastUs ? (uiRefUs * 100) / uiFastUs : 0;
+        ESP_LOGI(TAG, "%-8s %8u %8u %4u.%02u %s", ptCase->pcName, uiRefUs, uiFastUs, uiSpeedup / 100,
+                 uiSpeedup % 100, bExact ? "yes" : "NO, disabled");
+    }
+
+    s_uiKernels = uiKernels;
+    _lv_refr_set_disp_refreshing(ptDispOld);
+
+End_Func:
+    free(ptPattern);
+    free(ptRef);
+    free(ptFast);
+    free(pucMask);
+#else
+    ESP_LOGW(TAG, "only for LV_COLOR_DEPTH 16 without LV_COLOR_SCREEN_TRANSP");
+#endif
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+#if LVGL_BLEND_SUPPORTED
+/* Takes the place of lv_draw_sw_blend_basic() for color fills, lv_draw_sw_blend() already
+   dropped transparent draws and waited for the draw unit */
+static void LV_ATTRIBUTE_FAST_MEM lvgl_blend_cb(lv_draw_ctx_t* ptCtx, const lv_draw_sw_blend_dsc_t* ptDsc)
+{
+    lv_disp_t* ptDisp = _lv_refr_get_disp_refreshing();
+    const lv_opa_t* pucMask = ptDsc->mask_buf;
+    uint32_t uiKernel;
+
+    if (ptDsc->src_buf || ptDsc->blend_mode != LV_BLEND_MODE_NORMAL ||
+        ptDisp->driver->set_px_cb || ptDisp->driver->screen_transp)
+    {
+        lv_draw_sw_blend_basic(ptCtx, ptDsc);
+        return;
+    }
+
+    if (pucMask && ptDsc->mask_res == LV_DRAW_MASK_RES_TRANSP)
+    {
+        return;
+    }
+    if (ptDsc->mask_res == LV_DRAW_MASK_RES_FULL_COVER)
+    {
+        pucMask = NULL;
+    }
+
+    if (pucMask)
+    {
+        uiKernel = ptDsc->opa >= LV_OPA_MAX ? LVGL_BLEND_MASK : LVGL_BLEND_MASK_OPA;
+    }
+    else
+    {
+        uiKernel = ptDsc->opa >= LV_OPA_MAX ? LVGL_BLEND_FILL : LVGL_BLEND_FILL_OPA;
+    }
+    if ((s_uiKernels & uiKernel) == 0)
+    {
+        lv_draw_sw_blend_basic(ptCtx, ptDsc);
+        return;
+    }
+
+    lv_area_t tArea;
+    if (!_lv_area_intersect(&tArea, ptDsc->blend_area, ptCtx->clip_area))
+    {
+        return;
+    }
+
+    int32_t iStride = lv_area_get_width(ptCtx->buf_area);
+    lv_color_t* ptDest = (lv_color_t*)ptCtx->buf;
+    ptDest += iStride * (tArea.y1 - ptCtx->buf_area->y1) + (tArea.x1 - ptCtx->buf_area->x1);
+
+    int32_t iMaskStride = 0;
+    if (pucMask)
+    {
+        iMaskStride = lv_area_get_width(ptDsc->mask_area);
+        pucMask += iMaskStride * (tArea.y1 - ptDsc->mask_area->y1) + (tArea.x1 - ptDsc->mask_area->x1);
+    }
+
+    int32_t iW = lv_area_get_width(&tArea);
+    int32_t iH = lv_area_get_height(&tArea);
+    switch (uiKernel)
+    {
+        case LVGL_BLEND_FILL:
+            lvgl_blend_fill(ptDest, iW, iH, iStride, ptDsc->color);
+            break;
+        case LVGL_BLEND_FILL_OPA:
+            lvgl_blend_fill_opa(ptDest, iW, iH, iStride, ptDsc->color, ptDsc->opa);
+            break;
+        case LVGL_BLEND_MASK:
+            lvgl_blend_mask(ptDest, iW, iH, iStride, ptDsc->color, pucMask, iMaskStride);
+            break;
+        default:
+            lvgl_blend_mask_opa(ptDest, iW, iH, iStride, ptDsc->color, ptDsc->opa, pucMask, iMaskStride);
+            break;
+    }
+}
+
+static void LV_ATTRIBUTE_FAST_MEM lvgl_blend_fill(lv_color_t* ptDest, int32_t iW, int32_t iH, int32_t iStride,
+                                                  lv_color_t tColor)
+{
+    uint32_t uiC32 = PAIR(tColor.full);
+
+    for (int32_t y = 0; y < iH; y++)
+    {
+        uint16_t* pusDest = &ptDest->full;
+        int32_t x = iW;
+
+        if (IS_ODD_PX(pusDest) && x)
+        {
+            *pusDest++ = tColor.full;
+            x--;
+        }
+
+        /* 8 pixels per round, the loop overhead is as large as the stores otherwise */
+        uint32_t* puiDest = (uint32_t*)pusDest;
+        for (; x >= 8; x -= 8)
+        {
+            puiDest[0] = uiC32;
+            puiDest[1] = uiC32;
+            puiDest[2] = uiC32;
+            puiDest[3] = uiC32;
+            puiDest += 4;
+        }
+        for (; x >= 2; x -= 2)
+        {
+            *puiDest++ = uiC32;
+        }
+        if (x)
+        {
+            *(uint16_t*)puiDest = tColor.full;
+        }
+        ptDest += iStride;
+    }
+}
+
+/* Keeps the cache of fill_normal() as it is, starting at black and carried over the rows:
+   which pixels hit it decides the rounding of their mix, so this is what makes it bit-exact */
+static void LV_ATTRIBUTE_FAST_MEM lvgl_blend_fill_opa(lv_color_t* ptDest, int32_t iW, int32_t iH, int32_t iStride,
+                                                      lv_color_t tColor, lv_opa_t ucOpa)
+{
+    lv_color_t tLastDest = lv_color_black();
+    lv_color_t tLastRes = lv_color_mix(tColor, tLastDest, ucOpa);
+#if LV_COLOR_MIX_ROUND_OFS == 0
+    uint16_t ausPremult[3];
+    lv_color_premult(tColor, ucOpa, ausPremult);
+    lv_opa_t ucOpaInv = 255 - ucOpa;
+#endif
+
+    for (int32_t y = 0; y < iH; y++)
+    {
+        int32_t x = 0;
+
+        if (IS_ODD_PX(ptDest) && iW)
+        {
+            FILL_OPA_PX(ptDest[0]);
+            x = 1;
+        }
+
+        /* Four pixels that all equal the cached destination are two word compares and stores */
+        uint32_t uiLast32 = PAIR(tLastDest.full);
+        uint32_t uiRes32 = PAIR(tLastRes.full);
+        for (; x + 3 < iW; x += 4)
+        {
+            uint32_t* puiPair = (uint32_t*)&ptDest[x];
+            if (puiPair[0] == uiLast32 && puiPair[1] == uiLast32)
+            {
+                puiPair[0] = uiRes32;
+                puiPair[1] = uiRes32;
+                continue;
+            }
+            FILL_OPA_PX(ptDest[x]);
+            FILL_OPA_PX(ptDest[x + 1]);
+            FILL_OPA_PX(ptDest[x + 2]);
+            FILL_OPA_PX(ptDest[x + 3]);
+            uiLast32 = PAIR(tLastDest.full);
+            uiRes32 = PAIR(tLastRes.full);
+        }
+        for (; x < iW; x++)
+        {
+            FILL_OPA_PX(ptDest[x]);
+        }
+        ptDest += iStride;
+    }
+}
+
+static void LV_ATTRIBUTE_FAST_MEM lvgl_blend_mask(lv_color_t* ptDest, int32_t iW, int32_t iH, int32_t iStride,
+                                                  lv_color_t tColor, const lv_opa_t* pucMask, int32_t iMaskStride)
+{
+    uint32_t uiC32 = PAIR(tColor.full);
+
+    for (int32_t y = 0; y < iH; y++)
+    {
+        int32_t x = 0;
+
+        /* The mask is read a word, i.e. four pixels, at a time */
+        for (; x < iW && ((uintptr_t)&pucMask[x] & 0x3); x++)
+        {
+            MASK_PX(ptDest[x], pucMask[x]);
+        }
+        for (; x + 3 < iW; x += 4)
+        {
+            uint32_t uiM32 = *(const uint32_t*)&pucMask[x];
+            if (uiM32 == 0)
+            {
+                continue;
+            }
+            if (uiM32 == 0xFFFFFFFF)
+            {
+                if (IS_ODD_PX(&ptDest[x]))
+                {
+                    ptDest[x] = tColor;
+                    *(uint32_t*)&ptDest[x + 1] = uiC32;
+                    ptDest[x + 3] = tColor;
+                }
+                else
+                {
+                    ((uint32_t*)&ptDest[x])[0] = uiC32;
+                    ((uint32_t*)&ptDest[x])[1] = uiC32;
+                }
+                continue;
+            }
+            MASK_PX(ptDest[x], pucMask[x]);
+            MASK_PX(ptDest[x + 1], pucMask[x + 1]);
+            MASK_PX(ptDest[x + 2], pucMask[x + 2]);
+            MASK_PX(ptDest[x + 3], pucMask[x + 3]);
+        }
+        for (; x < iW; x++)
+        {
+            MASK_PX(ptDest[x], pucMask[x]);
+        }
+        ptDest += iStride;
+        pucMask += iMaskStride;
+    }
+}
+
+static void LV_ATTRIBUTE_FAST_MEM lvgl_blend_mask_opa(lv_color_t* ptDest, int32_t iW, int32_t iH, int32_t iStride,
+                                                      lv_color_t tColor, lv_opa_t ucOpa, const lv_opa_t* pucMask,
+                                                      int32_t iMaskStride)
+{
+    lv_color_t tLastDest = ptDest[0];
+    lv_color_t tLastRes = ptDest[0];
+    lv_opa_t ucLastMask = LV_OPA_TRANSP;
+    lv_opa_t ucOpaTmp = LV_OPA_TRANSP;
+
+    for (int32_t y = 0; y < iH; y++)
+    {
+        int32_t x = 0;
+
+        for (; x < iW && ((uintptr_t)&pucMask[x] & 0x3); x++)
+        {
+            MASK_OPA_PX(ptDest[x], pucMask[x]);
+        }
+        for (; x + 3 < iW; x += 4)
+        {
+            uint32_t uiM32 = *(const uint32_t*)&pucMask[x];
+            if (uiM32 == 0)
+            {
+                continue;
+            }
+            /* Inside a shape the mask and the destination repeat, reuse the last mix for all four */
+            if (uiM32 == ucLastMask * 0x01010101U && !IS_ODD_PX(&ptDest[x]))
+            {
+                uint32_t* puiPair = (uint32_t*)&ptDest[x];
+                uint32_t uiLast32 = PAIR(tLastDest.full);
+                if (puiPair[0] == uiLast32 && puiPair[1] == uiLast32)
+                {
+                    puiPair[0] = PAIR(tLastRes.full);
+                    puiPair[1] = puiPair[0];
+                    continue;
+                }
+            }
+            MASK_OPA_PX(ptDest[x], pucMask[x]);
+            MASK_OPA_PX(ptDest[x + 1], pucMask[x + 1]);
+            MASK_OPA_PX(ptDest[x + 2], pucMask[x + 2]);
+            MASK_OPA_PX(ptDest[x + 3], pucMask[x + 3]);
+        }
+        for (; x < iW; x++)
+        {
+            MASK_OPA_PX(ptDest[x], pucMask[x]);
+        }
+        ptDest += iStride;
+        pucMask += iMaskStride;
+    }
+}
+
+/* Runs of a few colors and of empty, full and partial mask bytes, like the edges and
+   insides of the benchmark's shapes. Fixed seed, so every run compares the same data */
+static void lvgl_blend_pattern(lv_color_t* ptColors, lv_opa_t* pucMask, uint32_t uiPx)
+{
+    static const uint16_t ausPalette[] = {0x0000, 0xFFFF, 0x7BEF, 0x1234};
+    uint32_t uiRnd = 0x12345678;
+    uint32_t i = 0;
+
+    while (i < uiPx)
+    {
+        uiRnd = uiRnd * 1103515245 + 12345;
+        uint32_t uiRun = 1 + ((uiRnd >> 16) & 0xF);
+        uint16_t usColor = ausPalette[(uiRnd >> 8) & 0x3];
+        for (; uiRun && i < uiPx; uiRun--, i++)
+        {
+            ptColors[i].full = usColor;
+        }
+    }
+
+    i = 0;
+    while (i < uiPx)
+    {
+        uiRnd = uiRnd * 1103515245 + 12345;
+        uint32_t uiRun = 1 + ((uiRnd >> 16) & 0xF);
+        uint32_t uiKind = (uiRnd >> 8) & 0x3;
+        for (; uiRun && i < uiPx; uiRun--, i++)
+        {
+            uiRnd = uiRnd * 1103515245 + 12345;
+            pucMask[i] = uiKind == 0 ? LV_OPA_TRANSP : uiKind == 1 ? (lv_opa_t)(uiRnd >> 24) : LV_OPA_COVER;
+        }
+    }
+}
+
+static uint32_t lvgl_blend_time(lv_draw_sw_ctx_t* ptCtx, const lv_draw_sw_blend_dsc_t* ptDsc, lv_color_t* ptBuf,
+                                const lv_color_t* ptPattern, uint32_t uiPx, lvgl_blend_cb_t pfnBlend)
+{
+    uint32_t uiCycles = 0;
+
+    ptCtx->base_draw.buf = ptBuf;
+    for (uint32_t r = 0; r < BLEND_BENCH_ROUNDS; r++)
+    {
+        memcpy(ptBuf, ptPattern, uiPx * sizeof(lv_color_t));
+        uint32_t uiStart = soc_get_ccount();
+        pfnBlend(&ptCtx->base_draw, ptDsc);
+        uiCycles += soc_get_ccount() - uiStart;
+    }
+    return uiCycles / BLEND_BENCH_ROUNDS / LVGL_CYCLES_PER_US;
+}
+#endif
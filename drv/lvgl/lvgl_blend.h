@@ -0,0 +1,58 @@
+/**
+ * @file lvgl_blend.h
+ * RGB565 fill and blend kernels that work on pixel pairs, installed as the blend callback of the sw draw context
+ */
+
+#ifndef LVGL_BLEND_H
+#define LVGL_BLEND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+/* Kernels, a disabled one leaves its case to lv_draw_sw_blend_basic() */
+#define LVGL_BLEND_FILL             (1 << 0)    /* solid fill */
+#define LVGL_BLEND_FILL_OPA         (1 << 1)    /* fill with opacity */
+#define LVGL_BLEND_MASK             (1 << 2)    /* fill through a mask */
+#define LVGL_BLEND_MASK_OPA         (1 << 3)    /* fill through a mask with opacity */
+#define LVGL_BLEND_ALL              (LVGL_BLEND_FILL | LVGL_BLEND_FILL_OPA | LVGL_BLEND_MASK | LVGL_BLEND_MASK_OPA)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* Set as lv_disp_drv_t::draw_ctx_init, initializes the sw draw context and takes over its blend callback.
+   Image blending and the other blend modes stay with LVGL */
+void lvgl_blend_ctx_init(lv_disp_drv_t* ptDrv, lv_draw_ctx_t* ptCtx);
+
+/* Choose the kernels in use, LVGL_BLEND_ALL by default */
+void lvgl_blend_set_kernels(uint32_t uiKernels);
+uint32_t lvgl_blend_get_kernels(void);
+
+/* Run every kernel and lv_draw_sw_blend_basic() on the same buffers, log the time of both and
+   disable the kernels whose output is not bit-exact. Needs a registered display */
+void lvgl_blend_benchmark(void);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LVGL_BLEND_H */
@@ -6,12 +6,17 @@
 /*********************
  *      INCLUDES
  *********************/
+#include <stdlib.h>
+#include <string.h>
 #include "sdkconfig.h"
 #include "lvgl_helpers.h"
+#include "lvgl_log.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "driver/soc.h"
 
 #include "lvgl_tft/disp_spi.h"
 
@@ -25,22 +30,70 @@
 
 #define TAG "lvgl_helpers"
 
+/* One half of the HSPI FIFO, W0-W7 or W8-W15 */
+#define SPI_FIFO_HALF_SIZE      (32)
+/* HSPI clock source, the dividers of spi_clk_div_t divide it */
+#define SPI_APB_HZ              (80 * 1000 * 1000)
+
 /**********************
  *      TYPEDEFS
  **********************/
+/* State of the color stream that is fed chunk by chunk from the SPI ISR */
+typedef struct
+{
+    const uint8_t* pucData;
+    uint32_t uiLen;
+    uint32_t uiDoneLen;
+    lvgl_spi_done_cb_t pfnDoneCb;
+    void* pArg;
+#if LVGL_SPI_STREAM_PINGPONG
+    uint32_t uiHalf;            /* FIFO half holding the preloaded chunk */
+    uint32_t uiPreload;         /* bytes preloaded there, 0 at the end of the stream */
+#endif
+    uint32_t uiStartCcount;     /* CCOUNT when the current chunk was started */
+    uint32_t uiBits;            /* its length on the wire, 0 before the first chunk */
+}lvgl_spi_async_t;
+
+#define SPI_BENCH_ROUNDS        (64)
+#define SPI_BENCH_MAX_LEN       (4096)
 
 /**********************
  *  STATIC PROTOTYPES
  **********************/
+static uint32_t lvgl_spi_load_chunk(const uint8_t* pucData, uint32_t uiLen);
+static bool lvgl_spi_async_next(void);
+static void lvgl_spi_stream_mark(uint32_t uiBits);
+#if LVGL_SPI_STREAM_PINGPONG
+static uint32_t lvgl_spi_fill_half(uint32_t uiHalf);
+#endif
 
 /**********************
  *  STATIC VARIABLES
  **********************/
 static SemaphoreHandle_t semphor = NULL;
 
+static lvgl_spi_async_t s_tAsync;
+static volatile bool s_bAsyncBusy = false;
+static lvgl_spi_stream_stats_t s_tStreamStats;
+static lvgl_spi_capture_cb_t s_pfnCapture = NULL;
+static lvgl_flush_stats_t s_tFlushStats;
+static uint32_t s_uiCyclesPerBit = CONFIG_ESP8266_DEFAULT_CPU_FREQ_MHZ / 40;   /* CPU cycles per bit on the wire */
+
 /**********************
  *      MACROS
  **********************/
+#if LVGL_SPI_CAPTURE
+/* DC is already at its level for the data when a transmit starts */
+#define LVGL_SPI_CAPTURE_DATA(pucData, uiBits)                                      \
+    do {                                                                            \
+        if (s_pfnCapture)                                                           \
+        {                                                                           \
+            s_pfnCapture((pucData), (uiBits), (GPIO.out >> CONFIG_LV_DISP_PIN_DC) & 1); \
+        }                                                                           \
+    } while (0)
+#else
+#define LVGL_SPI_CAPTURE_DATA(pucData, uiBits)
+#endif
 
 /**********************
  *   GLOBAL FUNCTIONS
@@ -52,100 +105,163 @@ void lvgl_spi_transmit(spi_master_mode_t tMode, const uint8_t* pucData, uint32_t
     {
         return;
     }
-    //LOGI( "SPI_SEND len:%u", len);
+    //LVGL_LOGI("SPI_SEND len:%u", uiLen);
 
     if (uiLen == 0)
     {
         return;
     }
 
-    if (!semphor)
-        xSemaphoreTake(semphor, portMAX_DELAY);
-    
-    uint32_t uiDoneLen = 0, uiTmpLen = 0;
-    
+#if LVGL_FLUSH_STATS
+    uint32_t uiStart = soc_get_ccount();
+#endif
+
+    /* A color stream may still be shifting out, never mix it with this data */
+    lvgl_spi_wait_idle();
+    LVGL_SPI_CAPTURE_DATA(pucData, uiLen * 8);
+
+    uint32_t uiDoneLen = 0;
+    do
+    {
+        uiDoneLen += lvgl_spi_load_chunk(pucData + uiDoneLen, uiLen - uiDoneLen);
+    }while (uiLen > uiDoneLen);
+
+#if LVGL_FLUSH_STATS
+    s_tFlushStats.ullSyncCycles += soc_get_ccount() - uiStart;
+    s_tFlushStats.uiSyncBytes += uiLen;
+#endif
+}
+
+void lvgl_spi_transmit_bits(const uint8_t* pucData, uint32_t uiBits)
+{
     spi_trans_t trans;
     uint32_t addr = 0x0;
-    //memset(&trans, 0x0, sizeof(trans));
-    trans.bits.val = 0;                     // clear all bit
+
+    if (uiBits == 0 || uiBits > LVGL_SPI_MAX_BITS)
+    {
+        return;
+    }
+
+    /* Only a color stream has to finish first, spi_trans() itself waits for the shifter,
+     * so the caller packs the next load while this one is on the wire */
+    while (s_bAsyncBusy)
+    {
+        xSemaphoreTake(semphor, portMAX_DELAY);
+    }
+
+    LVGL_SPI_CAPTURE_DATA(pucData, uiBits);
+
+#if LVGL_FLUSH_STATS
+    uint32_t uiStart = soc_get_ccount();
+#endif
+
+    trans.bits.val = 0;
     trans.addr = &addr;
+    trans.mosi = (uint32_t*)pucData;
+    trans.bits.mosi = uiBits;
 
-    uint32_t uiBuf[16] = {0};
-    trans.mosi = uiBuf;
-    
-    do
-    {        
-        uiTmpLen = (uiLen - uiDoneLen) > 64 ? 64 : (uiLen - uiDoneLen);
-        
-        if (uiTmpLen < 64)
-        {
-            if ((uiTmpLen % 4) > 0)
-            {
-                trans.bits.addr = (uiTmpLen % 4) * 8;
-                trans.bits.mosi = (uiTmpLen / 4) * 32;
-                memcpy(&addr, pucData + uiDoneLen, uiTmpLen % 4);
-                uint32_t uiTmp = addr;
-                addr = (uiTmp & 0xff) << 24;
-                addr += (uiTmp & 0xff00) << 8;
-                addr += (uiTmp & 0xff0000) >> 8;
-                addr += uiTmp >> 24;
-                //LOGI("bits.addr:%u bits.mosi:%u trans.addr:%#x", trans.bits.addr, trans.bits.mosi, *trans.addr);
-
-                if (uiTmpLen / 4)
-                {
-                    if (((uint32_t)(pucData + (uiDoneLen + uiTmpLen % 4)) / 4) == 0)
-                    {
-                        trans.mosi = (uint32_t*)(pucData + (uiDoneLen + uiTmpLen % 4));
-                    }
-                    else
-                    {
-                        memcpy(uiBuf, pucData + (uiDoneLen + (uiTmpLen % 4)), (uiTmpLen / 4) * 4);
-                    }
-                    //LOGI("trans.mosi[0]:%#x", trans.mosi[0]);
-                }
-                else
-                {
-                    trans.mosi = NULL;
-                }
-            }
-            else
-            {
-                trans.bits.addr = 0;
-                trans.bits.mosi = uiTmpLen * 8;
-                if ((((uint32_t)(pucData + uiDoneLen)) / 4) == 0)
-                {
-                    trans.mosi = (uint32_t*)(pucData + uiDoneLen);
-                }
-                else
-                {
-                    memcpy(uiBuf, pucData + uiDoneLen, uiTmpLen);
-                }
-                
-            }
-        }
-        else
-        {
-            trans.bits.addr = 0;
-            trans.bits.mosi = (64 * 8);
-            if ((((uint32_t)(pucData + uiDoneLen)) / 4) == 0)
-            {
-                trans.mosi = (uint32_t*)(pucData + uiDoneLen);
-            }
-            else
-            {
-                memcpy(uiBuf, pucData + uiDoneLen, 64);
-            }
-        }
-        spi_trans(HSPI_HOST, &trans);
-        uiDoneLen += uiTmpLen;
+    spi_trans(HSPI_HOST, &trans);
 
-    }while (uiLen > uiDoneLen);
-    
-    if (!semphor)
+#if LVGL_FLUSH_STATS
+    s_tFlushStats.ullSyncCycles += soc_get_ccount() - uiStart;
+    s_tFlushStats.uiSyncBytes += uiBits / 8;
+#endif
+}
+
+void lvgl_spi_transmit_async(const uint8_t* pucData, uint32_t uiLen, lvgl_spi_done_cb_t pfnDoneCb, void* pArg)
+{
+    bool bWoken;
+
+    lvgl_spi_wait_idle();
+
+    portENTER_CRITICAL();
+    bWoken = lvgl_spi_transmit_async_from_isr(pucData, uiLen, pfnDoneCb, pArg);
+    portEXIT_CRITICAL();
+
+    if (bWoken)
     {
-        //xSemaphoreTake(semphor, portMAX_DELAY);
-        xSemaphoreGive(semphor);
-    }    
+        taskYIELD();
+    }
+}
+
+bool IRAM_ATTR lvgl_spi_transmit_async_from_isr(const uint8_t* pucData, uint32_t uiLen, lvgl_spi_done_cb_t pfnDoneCb, void* pArg)
+{
+    if (uiLen == 0)
+    {
+        return pfnDoneCb ? pfnDoneCb(pArg) : false;
+    }
+
+    s_tAsync.pucData = pucData;
+    s_tAsync.uiLen = uiLen;
+    s_tAsync.pfnDoneCb = pfnDoneCb;
+    s_tAsync.pArg = pArg;
+
+    s_tAsync.uiBits = 0;
+    LVGL_SPI_CAPTURE_DATA(pucData, uiLen * 8);
+#if LVGL_FLUSH_STATS
+    s_tFlushStats.uiAsyncBytes += uiLen;
+#endif
+
+    /* Only the first chunk is loaded here, the rest is refilled from SPI_TRANS_DONE_EVENT */
+    s_bAsyncBusy = true;
+#if LVGL_SPI_STREAM_PINGPONG
+    /* The first chunk takes the head fix-up and W0-W7, the next one is preloaded
+     * into W8-W15 right away so the ISR only has to restart the shifter */
+    uint32_t uiFirst = ((4 - ((uint32_t)pucData & 0x3)) & 0x3) + SPI_FIFO_HALF_SIZE;
+    s_tAsync.uiDoneLen = lvgl_spi_load_chunk(pucData, uiFirst > uiLen ? uiLen : uiFirst);
+    lvgl_spi_stream_mark(s_tAsync.uiDoneLen * 8);
+    s_tAsync.uiHalf = 1;
+    s_tAsync.uiPreload = lvgl_spi_fill_half(s_tAsync.uiHalf);
+#else
+    s_tAsync.uiDoneLen = lvgl_spi_load_chunk(pucData, uiLen);
+    lvgl_spi_stream_mark(s_tAsync.uiDoneLen * 8);
+#endif
+
+    return false;
+}
+
+void lvgl_spi_wait_idle(void)
+{
+    while (s_bAsyncBusy)
+    {
+        xSemaphoreTake(semphor, portMAX_DELAY);
+    }
+
+    /* spi_trans() returns as soon as the last chunk is started, callers
+     * toggle DC right after this so the shifter has to be empty too */
+    while (SPI1.cmd.usr);
+}
+
+void lvgl_spi_set_capture(lvgl_spi_capture_cb_t pfnCb)
+{
+    s_pfnCapture = pfnCb;
+}
+
+void lvgl_flush_stats_add(uint32_t uiCycles)
+{
+    s_tFlushStats.uiFlushes++;
+    s_tFlushStats.ullFlushCycles += uiCycles;
+}
+
+void lvgl_get_flush_stats(lvgl_flush_stats_t* ptStats)
+{
+    portENTER_CRITICAL();
+    *ptStats = s_tFlushStats;
+    portEXIT_CRITICAL();
+}
+
+void lvgl_spi_get_stream_stats(lvgl_spi_stream_stats_t* ptStats)
+{
+    portENTER_CRITICAL();
+    *ptStats = s_tStreamStats;
+    portEXIT_CRITICAL();
+}
+
+void lvgl_spi_reset_stream_stats(void)
+{
+    portENTER_CRITICAL();
+    memset(&s_tStreamStats, 0, sizeof(s_tStreamStats));
+    portEXIT_CRITICAL();
 }
 
 static void IRAM_ATTR spi_event_callback(int event, void *arg)
@@ -158,13 +274,30 @@ static void IRAM_ATTR spi_event_callback(int event, void *arg)
         break;
 
         case SPI_TRANS_START_EVENT: {
-            //xSemaphoreTakeFromISR(semphor, &xHigherPriorityTaskWoken);
         }
         break;
 
         case SPI_TRANS_DONE_EVENT: {
-            //if (!semphor)
-                //xSemaphoreGiveFromISR(semphor, &xHigherPriorityTaskWoken);
+            /* Stale done of a previous transfer while the current chunk is still shifting out */
+            if (!s_bAsyncBusy || SPI1.cmd.usr)
+            {
+                break;
+            }
+
+            if (!lvgl_spi_async_next())
+            {
+#if LVGL_SPI_STREAM_PINGPONG
+                /* spi_trans() always loads W0, point the shifter back there for the next user */
+                SPI1.user.usr_mosi_highpart = 0;
+#endif
+                /* The callback may chain the next transmit with lvgl_spi_transmit_async_from_isr() */
+                s_bAsyncBusy = false;
+                if (s_tAsync.pfnDoneCb && s_tAsync.pfnDoneCb(s_tAsync.pArg))
+                {
+                    xHigherPriorityTaskWoken = pdTRUE;
+                }
+                xSemaphoreGiveFromISR(semphor, &xHigherPriorityTaskWoken);
+            }
         }
         break;
 
@@ -186,9 +319,14 @@ void lvgl_spi_init()
     semphor = xSemaphoreCreateBinary();
     spi_config_t spi_config;
     // Load default interface parameters
-    // CS_EN:1, MISO_EN:1, MOSI_EN:1, BYTE_TX_ORDER:1, BYTE_TX_ORDER:1, BIT_RX_ORDER:0, BIT_TX_ORDER:0, CPHA:0, CPOL:0
+    // CS_EN:1, MISO_EN:1, MOSI_EN:1, BYTE_TX_ORDER:0, BYTE_RX_ORDER:0, BIT_RX_ORDER:0, BIT_TX_ORDER:0, CPHA:0, CPOL:0
     spi_config.interface.val = SPI_DEFAULT_INTERFACE;
 
+    /* FIFO words go out in memory order, byte 0 first. Byte order on the wire is decided by
+     * the data alone: commands are byte arrays and colors are rendered with LV_COLOR_16_SWAP */
+    spi_config.interface.byte_tx_order = 0;
+    spi_config.interface.byte_rx_order = 0;
+
     // Load default interrupt enable
     // TRANS_DONE: true, WRITE_STATUS: false, READ_STATUS: false, WRITE_BUFFER: false, READ_BUFFER: false
     spi_config.intr_enable.val = SPI_MASTER_DEFAULT_INTR_ENABLE;
@@ -205,13 +343,121 @@ void lvgl_spi_init()
     // ESP8266 Only support half-duplex
     spi_config.mode = SPI_MASTER_MODE;
     // Set the SPI clock frequency division factor
-    spi_config.clk_div = SPI_40MHz_DIV;
+    // The fastest one the selected panel takes, 0 is a panel that is not on SPI
+    static const spi_clk_div_t s_atDivs[] = {
+        SPI_40MHz_DIV, SPI_20MHz_DIV, SPI_16MHz_DIV, SPI_10MHz_DIV,
+        SPI_8MHz_DIV, SPI_5MHz_DIV, SPI_4MHz_DIV, SPI_2MHz_DIV
+    };
+    uint32_t uiMaxHz = disp_driver_get()->max_spi_hz;
+    uint32_t d = 0;
+    while (uiMaxHz && d < sizeof(s_atDivs) / sizeof(s_atDivs[0]) - 1 && SPI_APB_HZ / s_atDivs[d] > uiMaxHz)
+    {
+        d++;
+    }
+    spi_config.clk_div = s_atDivs[d];
+    s_uiCyclesPerBit = CONFIG_ESP8266_DEFAULT_CPU_FREQ_MHZ * s_atDivs[d] / (SPI_APB_HZ / 1000000);
+    LOGI("spi clock:%u Hz for %s", SPI_APB_HZ / s_atDivs[d], disp_driver_get()->name);
     spi_config.event_cb = spi_event_callback;
     LOGI("init spi");
     spi_init(HSPI_HOST, &spi_config);
     LOGI("End <<");
 }
 
+/* Push aligned and unaligned sources of various lengths through lvgl_spi_transmit()
+ * and log the throughput. The bytes land on the panel, so run it before the GUI draws. */
+void lvgl_spi_benchmark(void)
+{
+    static const uint32_t uiLens[] = {4, 17, 64, 67, 480, 1024, SPI_BENCH_MAX_LEN};
+
+    uint8_t* pucBuf = (uint8_t*)malloc(SPI_BENCH_MAX_LEN + 4);
+    if (pucBuf == NULL)
+    {
+        LOGE("malloc fail!!");
+        return;
+    }
+
+    for (uint32_t i = 0; i < SPI_BENCH_MAX_LEN + 4; i++)
+    {
+        pucBuf[i] = (uint8_t)i;
+    }
+
+    LOGI("%6s %6s %12s", "len", "offset", "bytes/s");
+    for (uint32_t l = 0; l < sizeof(uiLens) / sizeof(uiLens[0]); l++)
+    {
+        /* offset 0 is the zero-copy path, 1..3 take the head fix-up */
+        for (uint32_t uiOfs = 0; uiOfs < 4; uiOfs++)
+        {
+            lvgl_spi_wait_idle();
+            int64_t llStart = esp_timer_get_time();
+            for (uint32_t r = 0; r < SPI_BENCH_ROUNDS; r++)
+            {
+                lvgl_spi_transmit(SPI_SEND, pucBuf + uiOfs, uiLens[l]);
+            }
+            lvgl_spi_wait_idle();
+            int64_t llUs = esp_timer_get_time() - llStart;
+
+            uint64_t ullRate = llUs > 0 ? ((uint64_t)uiLens[l] * SPI_BENCH_ROUNDS * 1000000) / llUs : 0;
+            LOGI("%6u %6u %12u", uiLens[l], uiOfs, (uint32_t)ullRate);
+        }
+    }
+
+    /* The color stream path, the idle gaps between its chunks are what is left to win */
+    LOGI("%6s %6s %8s %8s %10s %6s", "stream", "offset", "chunks", "gaps", "max_gap", "util%");
+    for (uint32_t uiOfs = 0; uiOfs < 4; uiOfs++)
+    {
+        lvgl_spi_stream_stats_t tStats;
+
+        lvgl_spi_wait_idle();
+        lvgl_spi_reset_stream_stats();
+        for (uint32_t r = 0; r < SPI_BENCH_ROUNDS; r++)
+        {
+            lvgl_spi_transmit_async(pucBuf + uiOfs, SPI_BENCH_MAX_LEN, NULL, NULL);
+        }
+        lvgl_spi_wait_idle();
+        lvgl_spi_get_stream_stats(&tStats);
+
+        uint64_t ullTotal = tStats.ullBusyCycles + tStats.ullGapCycles;
+        uint32_t uiUtil = ullTotal ? (uint32_t)((tStats.ullBusyCycles * 100) / ullTotal) : 0;
+        LOGI("%6u %6u %8u %8u %10u %6u", SPI_BENCH_MAX_LEN, uiOfs, tStats.uiChunks, tStats.uiGaps,
+             tStats.uiMaxGapCycles, uiUtil);
+    }
+
+    /* A color flush as LVGL hands it over: aligned and already in wire order, so no byte of it
+     * is handled on its own. For comparison the swap pass it would need without LV_COLOR_16_SWAP */
+    lvgl_flush_stats_t tBefore, tAfter;
+    uint32_t uiTxCycles = 0;
+    uint32_t uiSwapCycles = 0;
+
+    lvgl_spi_wait_idle();
+    lvgl_get_flush_stats(&tBefore);
+    for (uint32_t r = 0; r < SPI_BENCH_ROUNDS; r++)
+    {
+        uint32_t uiStart = soc_get_ccount();
+        lvgl_spi_transmit_async(pucBuf, SPI_BENCH_MAX_LEN, NULL, NULL);
+        uiTxCycles += soc_get_ccount() - uiStart;
+        lvgl_spi_wait_idle();
+
+        uint16_t* pusPx = (uint16_t*)pucBuf;
+        uiStart = soc_get_ccount();
+        for (uint32_t i = 0; i < SPI_BENCH_MAX_LEN / 2; i++)
+        {
+            pusPx[i] = (pusPx[i] >> 8) | (pusPx[i] << 8);
+        }
+        uiSwapCycles += soc_get_ccount() - uiStart;
+    }
+    lvgl_get_flush_stats(&tAfter);
+
+    /* Per full draw buffer of the panel in use */
+    uint32_t uiBufPx = disp_driver_buf_size();
+    uint64_t ullDiv = (uint64_t)SPI_BENCH_MAX_LEN * SPI_BENCH_ROUNDS * LVGL_CYCLES_PER_US;
+    LOGI("%6s %8s %10s %10s", "pixels", "fixup_B", "start_us", "swap_us");
+    LOGI("%6u %8u %10u %10u", uiBufPx, tAfter.uiFixupBytes - tBefore.uiFixupBytes,
+         (uint32_t)(((uint64_t)uiTxCycles * uiBufPx * 2) / ullDiv),
+         (uint32_t)(((uint64_t)uiSwapCycles * uiBufPx * 2) / ullDiv));
+
+    free(pucBuf);
+}
+
 /* Interface and driver initialization */
 void lvgl_driver_init(void)
 {
@@ -221,13 +467,15 @@ void lvgl_driver_init(void)
     LOGI("Display hor size: %d, ver size: %d", LV_HOR_RES_MAX, LV_VER_RES_MAX);
 #endif
 
-    LOGI("Display buffer size: %d", DISP_BUF_SIZE);
+    LOGI("Display %s %dx%d, buffer size: %u", disp_driver_get()->name, disp_driver_get()->hor_res,
+         disp_driver_get()->ver_res, disp_driver_buf_size());
 
 /* Display controller initialization */
 #if defined CONFIG_LV_TFT_DISPLAY_PROTOCOL_SPI
     LOGI("Initializing SPI master for display");
 
     lvgl_spi_init();
+    disp_spi_init();
 
     disp_driver_init();
 #elif defined (CONFIG_LV_I2C_DISPLAY)
@@ -237,3 +485,137 @@ void lvgl_driver_init(void)
 #endif
 }
 
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/* Load the next chunk into the HSPI FIFO and start the transfer, returns the bytes consumed.
+ * Aligned data goes straight from pucData to the FIFO. An unaligned start is fixed up once:
+ * its 1..3 head bytes ride in the address phase, so every following chunk is aligned and the
+ * tail is just a shorter mosi bit length. Called from the task and from the SPI ISR. */
+static uint32_t IRAM_ATTR lvgl_spi_load_chunk(const uint8_t* pucData, uint32_t uiLen)
+{
+    spi_trans_t trans;
+    uint32_t addr = 0x0;
+    uint32_t uiHead = (4 - ((uint32_t)pucData & 0x3)) & 0x3;
+
+    trans.bits.val = 0;                     // clear all bit
+    trans.addr = &addr;
+    trans.mosi = NULL;
+
+    if (uiHead > uiLen)
+    {
+        uiHead = uiLen;
+    }
+
+    if (uiHead)
+    {
+        /* The address phase shifts out MSB first, the first byte goes to bit 31 */
+        for (uint32_t i = 0; i < uiHead; i++)
+        {
+            addr |= (uint32_t)pucData[i] << (24 - 8 * i);
+        }
+        trans.bits.addr = uiHead * 8;
+#if LVGL_FLUSH_STATS
+        s_tFlushStats.uiFixupBytes += uiHead;
+#endif
+    }
+
+    uint32_t uiBody = (uiLen - uiHead) > 64 ? 64 : (uiLen - uiHead);
+    if (uiBody)
+    {
+        /* spi_trans() reads whole words, the tail word never crosses the aligned end */
+        trans.mosi = (uint32_t*)(pucData + uiHead);
+        trans.bits.mosi = uiBody * 8;
+    }
+
+    spi_trans(HSPI_HOST, &trans);
+
+    return uiHead + uiBody;
+}
+
+/* Start the next chunk of the async stream, returns false once everything is on the wire */
+static bool IRAM_ATTR lvgl_spi_async_next(void)
+{
+#if LVGL_SPI_STREAM_PINGPONG
+    if (s_tAsync.uiPreload == 0)
+    {
+        return false;
+    }
+
+    /* The preloaded half goes out first, the address phase only ever carries the head fix-up */
+    SPI1.user.usr_addr = 0;
+    SPI1.user.usr_mosi = 1;
+    SPI1.user.usr_mosi_highpart = s_tAsync.uiHalf;
+    SPI1.user1.usr_mosi_bitlen = s_tAsync.uiPreload * 8 - 1;
+    SPI1.cmd.usr = 1;
+    lvgl_spi_stream_mark(s_tAsync.uiPreload * 8);
+
+    /* Then refill the half that just finished shifting out */
+    s_tAsync.uiHalf ^= 1;
+    s_tAsync.uiPreload = lvgl_spi_fill_half(s_tAsync.uiHalf);
+#else
+    if (s_tAsync.uiLen == s_tAsync.uiDoneLen)
+    {
+        return false;
+    }
+
+    /* Refill the FIFO with the next chunk and start it right away */
+    uint32_t uiBytes = lvgl_spi_load_chunk(s_tAsync.pucData + s_tAsync.uiDoneLen,
+                                           s_tAsync.uiLen - s_tAsync.uiDoneLen);
+    s_tAsync.uiDoneLen += uiBytes;
+    lvgl_spi_stream_mark(uiBytes * 8);
+#endif
+    return true;
+}
+
+#if LVGL_SPI_STREAM_PINGPONG
+/* Copy the next 32 bytes of the stream into one FIFO half, returns the bytes copied.
+ * The data is aligned here, the head fix-up is done by the first chunk. */
+static uint32_t IRAM_ATTR lvgl_spi_fill_half(uint32_t uiHalf)
+{
+    uint32_t uiBytes = s_tAsync.uiLen - s_tAsync.uiDoneLen;
+    if (uiBytes > SPI_FIFO_HALF_SIZE)
+    {
+        uiBytes = SPI_FIFO_HALF_SIZE;
+    }
+
+    const uint32_t* puiSrc = (const uint32_t*)(s_tAsync.pucData + s_tAsync.uiDoneLen);
+    volatile uint32_t* puiDst = &SPI1.data_buf[uiHalf * (SPI_FIFO_HALF_SIZE / 4)];
+    for (uint32_t i = 0; i < (uiBytes + 3) / 4; i++)
+    {
+        puiDst[i] = puiSrc[i];
+    }
+
+    s_tAsync.uiDoneLen += uiBytes;
+    return uiBytes;
+}
+#endif
+
+/* Account a chunk that was just started. Whatever passed since the previous start beyond
+ * the time its bits needed on the wire, the bus sat idle. */
+static void IRAM_ATTR lvgl_spi_stream_mark(uint32_t uiBits)
+{
+    uint32_t uiNow = soc_get_ccount();
+
+    if (s_tAsync.uiBits)
+    {
+        uint32_t uiElapsed = uiNow - s_tAsync.uiStartCcount;
+        uint32_t uiBusy = s_tAsync.uiBits * s_uiCyclesPerBit;
+
+        if (uiElapsed > uiBusy)
+        {
+            s_tStreamStats.uiGaps++;
+            s_tStreamStats.ullGapCycles += uiElapsed - uiBusy;
+            if (uiElapsed - uiBusy > s_tStreamStats.uiMaxGapCycles)
+            {
+                s_tStreamStats.uiMaxGapCycles = uiElapsed - uiBusy;
+            }
+        }
+    }
+
+    s_tStreamStats.uiChunks++;
+    s_tStreamStats.ullBusyCycles += uiBits * s_uiCyclesPerBit;
+    s_tAsync.uiStartCcount = uiNow;
+    s_tAsync.uiBits = uiBits;
+}
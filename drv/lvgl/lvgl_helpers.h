@@ -13,7 +13,9 @@ extern "C" {
  *      INCLUDES
  *********************/
 #include <stdbool.h>
+#include <stdint.h>
 
+#include "sdkconfig.h"
 #include "lvgl_spi_conf.h"
 #include "lvgl_tft/disp_driver.h"
 
@@ -36,6 +38,33 @@ extern "C" {
 #define CONFIG_LV_PREDEFINED_DISPLAY_NONE               (1)
 #define CONFIG_LV_INVERT_COLORS                         (0)
 
+/* Panel drivers linked into the image, the "panel" entry of the stored config picks one at boot,
+ * see disp_driver_select(). "null" drops the pixels, for benchmarking the rendering alone */
+#define LVGL_DISP_ILI9341                               (1)
+#define LVGL_DISP_ILI9488                               (1)
+#define LVGL_DISP_NULL                                  (1)
+#define LVGL_DISP_DEFAULT                               "ili9341"
+
+/* Stream colors through the two 32-byte halves of the HSPI FIFO: the SPI ISR only restarts
+ * the shifter on the preloaded half and refills the other one while it shifts out */
+#define LVGL_SPI_STREAM_PINGPONG                        (1)
+
+/* ILI9341 on the 3-line 9-bit serial interface (IM[3:0] = 0101): D/C travels in-band,
+ * CONFIG_LV_DISP_PIN_DC is left alone. The host tests build both interfaces */
+#ifndef CONFIG_LV_DISP_SPI_3WIRE
+#define CONFIG_LV_DISP_SPI_3WIRE                        (0)
+#endif
+
+/* One FIFO load for lvgl_spi_transmit_bits(), rounded down to whole 9-bit units so CS never rises inside one */
+#define LVGL_SPI_MAX_BITS                               (504)
+
+/* Pass everything that goes out on HSPI to the callback of lvgl_spi_set_capture() */
+#define LVGL_SPI_CAPTURE                                (0)
+
+/* Count CPU cycles spent in disp_driver_flush() and blocked in lvgl_spi_transmit(), see lvgl_get_flush_stats() */
+#define LVGL_FLUSH_STATS                                (1)
+#define LVGL_CYCLES_PER_US                              (CONFIG_ESP8266_DEFAULT_CPU_FREQ_MHZ)
+
 /*********  touch  ************/
 // XPT2046
 #define CONFIG_LV_TOUCH_PIN_IRQ                         (9)     // gpio_9
@@ -124,6 +153,37 @@ typedef enum
     SPI_RECV
 }spi_master_mode_t;
 
+/* Called from the SPI ISR once the last byte of an asynchronous transmit is on the wire.
+ * Returns true when it woke a higher priority task, the ISR yields once on its way out */
+typedef bool (*lvgl_spi_done_cb_t)(void* pArg);
+
+/* Bus usage of the async stream, in CPU cycles. The gaps are only counted between
+ * chunks of the same stream, the bus being idle between two streams is not a gap. */
+typedef struct
+{
+    uint32_t uiChunks;
+    uint32_t uiGaps;
+    uint32_t uiMaxGapCycles;
+    uint64_t ullGapCycles;
+    uint64_t ullBusyCycles;
+}lvgl_spi_stream_stats_t;
+
+/* Where the display path spends its time, in CPU cycles. Flush cycles include the sync
+ * cycles of transmits done inside the flush, the async bytes are fed from the SPI ISR. */
+typedef struct
+{
+    uint32_t uiFlushes;
+    uint64_t ullFlushCycles;
+    uint64_t ullSyncCycles;
+    uint32_t uiSyncBytes;
+    uint32_t uiAsyncBytes;
+    uint32_t uiFixupBytes;      /* bytes of unaligned heads, the only ones the transmit path handles one by one */
+}lvgl_flush_stats_t;
+
+/* Sees every transmit with the DC level it goes out with, uiBits is a multiple of 8 except
+ * for lvgl_spi_transmit_bits(). Async streams are reported from the SPI ISR, keep it IRAM_ATTR. */
+typedef void (*lvgl_spi_capture_cb_t)(const uint8_t* pucData, uint32_t uiBits, bool bDc);
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -135,6 +195,39 @@ void lvgl_driver_init(void);
 
 void lvgl_spi_transmit(spi_master_mode_t tMode, const uint8_t* pucData, uint32_t uiLen);
 
+/* Start transmitting pucData and return at once, the remaining chunks are fed from the SPI ISR.
+ * pucData must stay valid until pfnDoneCb is called. */
+void lvgl_spi_transmit_async(const uint8_t* pucData, uint32_t uiLen, lvgl_spi_done_cb_t pfnDoneCb, void* pArg);
+
+/* Same as lvgl_spi_transmit_async() without waiting, only valid while the bus is idle,
+ * e.g. from a lvgl_spi_done_cb_t to chain the next transmit. An empty transmit calls
+ * pfnDoneCb at once, its return is passed back so the caller can yield for it. */
+bool lvgl_spi_transmit_async_from_isr(const uint8_t* pucData, uint32_t uiLen, lvgl_spi_done_cb_t pfnDoneCb, void* pArg);
+
+/* Clock out uiBits bits of pucData in one transfer, for bit streams that are not made of bytes
+ * such as the 9-bit interface. pucData must be 4-byte aligned, uiBits <= LVGL_SPI_MAX_BITS. */
+void lvgl_spi_transmit_bits(const uint8_t* pucData, uint32_t uiBits);
+
+/* Install the wire capture, NULL removes it. Only effective with LVGL_SPI_CAPTURE. */
+void lvgl_spi_set_capture(lvgl_spi_capture_cb_t pfnCb);
+
+/* Block until no asynchronous transmit is in flight and the SPI shifter is idle */
+void lvgl_spi_wait_idle(void);
+
+/* Snapshot the async stream counters, lvgl_spi_reset_stream_stats() clears them */
+void lvgl_spi_get_stream_stats(lvgl_spi_stream_stats_t* ptStats);
+void lvgl_spi_reset_stream_stats(void);
+
+/* Account one disp_driver_flush() call that took uiCycles */
+void lvgl_flush_stats_add(uint32_t uiCycles);
+
+/* Snapshot of the flush counters, they only ever grow, callers work with differences */
+void lvgl_get_flush_stats(lvgl_flush_stats_t* ptStats);
+
+/* Log lvgl_spi_transmit() throughput for aligned and unaligned sources, the bus utilization of the stream
+ * and the CPU work a color flush costs on its way out */
+void lvgl_spi_benchmark(void);
+
 /**********************
  *      MACROS
  **********************/
@@ -0,0 +1,231 @@
+/**
+ * @file lvgl_log.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "lvgl_log.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TAG "lvgl_log"
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+/* Header of a record in the ring, the payload follows: uiArgc words for a format record,
+   usLen bytes of text when pcFmt is NULL */
+typedef struct
+{
+    uint32_t uiTime;            /* ms */
+    const char* pcTag;
+    const char* pcFmt;
+    uint8_t ucLevel;
+    uint8_t ucArgc;
+    uint16_t usLen;             /* payload bytes */
+} lvgl_log_hdr_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void lvgl_log_put(const lvgl_log_hdr_t* ptHdr, const void* pPayload);
+static void lvgl_log_copy_in(uint32_t uiPos, const void* pSrc, uint32_t uiLen);
+static void lvgl_log_copy_out(uint32_t uiPos, void* pDst, uint32_t uiLen);
+static void lvgl_log_task(void* pvParameter);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+/* Writers reserve and fill a record inside one short critical section. Without a compare-and-swap
+   on the ESP8266 that is the cheapest way to keep writers of any task apart, and no UART wait ever
+   happens in there */
+static uint8_t s_aucRing[LVGL_LOG_RING_SIZE] __attribute__((aligned(4)));
+static uint32_t s_uiHead = 0;
+static uint32_t s_uiTail = 0;
+static uint32_t s_uiDropped = 0;
+
+/**********************
+ *      MACROS
+ **********************/
+#define REC_SIZE(len)       ((sizeof(lvgl_log_hdr_t) + (len) + 3) & ~3U)
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lvgl_log_init(uint32_t uiPriority)
+{
+    if (xTaskCreate(lvgl_log_task, "lvgl_log", 2048, NULL, uiPriority, NULL) != pdPASS)
+    {
+        ESP_LOGE(TAG, "xTaskCreate lvgl_log fail!!");
+    }
+}
+
+void lvgl_log_text(esp_log_level_t eLevel, const char* pcTag, const char* pcText)
+{
+    lvgl_log_hdr_t tHdr;
+    uint32_t uiLen = strnlen(pcText, LVGL_LOG_TEXT_MAX);
+
+    /* LVGL ends its lines with a newline, the drain task adds its own */
+    while (uiLen && (pcText[uiLen - 1] == '\n' || pcText[uiLen - 1] == '\r'))
+    {
+        uiLen--;
+    }
+
+    tHdr.uiTime = esp_log_timestamp();
+    tHdr.pcTag = pcTag;
+    tHdr.pcFmt = NULL;
+    tHdr.ucLevel = eLevel;
+    tHdr.ucArgc = 0;
+    tHdr.usLen = uiLen;
+    lvgl_log_put(&tHdr, pcText);
+}
+
+void lvgl_log_write(esp_log_level_t eLevel, const char* pcTag, const char* pcFmt, uint32_t uiArgc, ...)
+{
+    lvgl_log_hdr_t tHdr;
+    uint32_t auiArgs[LVGL_LOG_ARGS_MAX];
+    va_list tArgs;
+
+    if (uiArgc > LVGL_LOG_ARGS_MAX)
+    {
+        uiArgc = LVGL_LOG_ARGS_MAX;
+    }
+    va_start(tArgs, uiArgc);
+    for (uint32_t i = 0; i < uiArgc; i++)
+    {
+        auiArgs[i] = va_arg(tArgs, uint32_t);
+    }
+    va_end(tArgs);
+
+    tHdr.uiTime = esp_log_timestamp();
+    tHdr.pcTag = pcTag;
+    tHdr.pcFmt = pcFmt;
+    tHdr.ucLevel = eLevel;
+    tHdr.ucArgc = uiArgc;
+    tHdr.usLen = uiArgc * sizeof(uint32_t);
+    lvgl_log_put(&tHdr, auiArgs);
+}
+
+uint32_t lvgl_log_get_dropped(void)
+{
+    return s_uiDropped;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void lvgl_log_put(const lvgl_log_hdr_t* ptHdr, const void* pPayload)
+{
+    uint32_t uiSize = REC_SIZE(ptHdr->usLen);
+
+    portENTER_CRITICAL();
+    if (LVGL_LOG_RING_SIZE - (s_uiHead - s_uiTail) < uiSize)
+    {
+        s_uiDropped++;
+    }
+    else
+    {
+        lvgl_log_copy_in(s_uiHead, ptHdr, sizeof(lvgl_log_hdr_t));
+        lvgl_log_copy_in(s_uiHead + sizeof(lvgl_log_hdr_t), pPayload, ptHdr->usLen);
+        s_uiHead += uiSize;
+    }
+    portEXIT_CRITICAL();
+}
+
+static void lvgl_log_copy_in(uint32_t uiPos, const void* pSrc, uint32_t uiLen)
+{
+    uint32_t uiOff = uiPos & (LVGL_LOG_RING_SIZE - 1);
+    uint32_t uiFirst = LVGL_LOG_RING_SIZE - uiOff;
+
+    if (uiFirst >= uiLen)
+    {
+        memcpy(&s_aucRing[uiOff], pSrc, uiLen);
+    }
+    else
+    {
+        memcpy(&s_aucRing[uiOff], pSrc, uiFirst);
+        memcpy(s_aucRing, (const uint8_t*)pSrc + uiFirst, uiLen - uiFirst);
+    }
+}
+
+static void lvgl_log_copy_out(uint32_t uiPos, void* pDst, uint32_t uiLen)
+{
+    uint32_t uiOff = uiPos & (LVGL_LOG_RING_SIZE - 1);
+    uint32_t uiFirst = LVGL_LOG_RING_SIZE - uiOff;
+
+    if (uiFirst >= uiLen)
+    {
+        memcpy(pDst, &s_aucRing[uiOff], uiLen);
+    }
+    else
+    {
+        memcpy(pDst, &s_aucRing[uiOff], uiFirst);
+        memcpy((uint8_t*)pDst + uiFirst, s_aucRing, uiLen - uiFirst);
+    }
+}
+
+/* Formats and writes the records, the only place that waits for the UART */
+static void lvgl_log_task(void* pvParameter)
+{
+    static const char s_acLetter[] = {'N', 'E', 'W', 'I', 'D', 'V'};
+    lvgl_log_hdr_t tHdr;
+    uint32_t auiPayload[(LVGL_LOG_TEXT_MAX + 3) / 4 + 1] = {0};
+    char acLine[LVGL_LOG_TEXT_MAX + 1];
+    uint32_t uiDroppedSeen = 0;
+
+    (void) pvParameter;
+    while (1)
+    {
+        vTaskDelay(pdMS_TO_TICKS(LVGL_LOG_DRAIN_MS));
+
+        while (1)
+        {
+            /* Only this task moves the tail, the writers only look at it */
+            portENTER_CRITICAL();
+            bool bEmpty = (s_uiHead == s_uiTail);
+            portEXIT_CRITICAL();
+            if (bEmpty)
+            {
+                break;
+            }
+            lvgl_log_copy_out(s_uiTail, &tHdr, sizeof(tHdr));
+            lvgl_log_copy_out(s_uiTail + sizeof(tHdr), auiPayload, tHdr.usLen);
+            portENTER_CRITICAL();
+            s_uiTail += REC_SIZE(tHdr.usLen);
+            portEXIT_CRITICAL();
+
+            if (tHdr.pcFmt == NULL)
+            {
+                memcpy(acLine, auiPayload, tHdr.usLen);
+                acLine[tHdr.usLen] = '\0';
+            }
+            else
+            {
+                const uint32_t* a = auiPayload;
+                snprintf(acLine, sizeof(acLine), tHdr.pcFmt, a[0], a[1], a[2], a[3], a[4], a[5]);
+            }
+
+            char cLetter = tHdr.ucLevel < sizeof(s_acLetter) ? s_acLetter[tHdr.ucLevel] : '?';
+            esp_log_write(tHdr.ucLevel, tHdr.pcTag, "%c (%u) %s: %s\n", cLetter, tHdr.uiTime, tHdr.pcTag, acLine);
+        }
+
+        uint32_t uiDropped = s_uiDropped;
+        if (uiDropped != uiDroppedSeen)
+        {
+            ESP_LOGW(TAG, "%u record(s) dropped, ring full", uiDropped - uiDroppedSeen);
+            uiDroppedSeen = uiDropped;
+        }
+    }
+}
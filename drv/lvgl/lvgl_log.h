@@ -0,0 +1,67 @@
+/**
+ * @file lvgl_log.h
+ * Log records kept in a RAM ring and written to the UART by a low priority task
+ */
+
+#ifndef LVGL_LOG_H
+#define LVGL_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_log.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define LVGL_LOG_RING_SIZE          (4096)  /* bytes, power of two */
+#define LVGL_LOG_TEXT_MAX           (128)   /* longer text records are cut */
+#define LVGL_LOG_ARGS_MAX           (6)
+#define LVGL_LOG_DRAIN_MS           (50)    /* period of the drain task */
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* Create the drain task, records written before are kept */
+void lvgl_log_init(uint32_t uiPriority);
+
+/* Copy a formatted line, for print callbacks that only hand over text */
+void lvgl_log_text(esp_log_level_t eLevel, const char* pcTag, const char* pcText);
+
+/* Keep the format pointer and up to LVGL_LOG_ARGS_MAX 32 bit arguments, the drain task formats them.
+   pcTag, pcFmt and %s arguments must be static strings, 64 bit and floating point values are not supported.
+   Use LVGL_LOG() rather than calling this directly */
+void lvgl_log_write(esp_log_level_t eLevel, const char* pcTag, const char* pcFmt, uint32_t uiArgc, ...);
+
+/* Records dropped because the ring was full */
+uint32_t lvgl_log_get_dropped(void);
+
+/**********************
+ *      MACROS
+ **********************/
+#define LVGL_LOG_NARGS(...)         LVGL_LOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define LVGL_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, N, ...) N
+
+#define LVGL_LOG(level, tag, fmt, ...) \
+    lvgl_log_write(level, tag, fmt, LVGL_LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__)
+
+/* LOGE/LOGI of the SDK for the flush and transaction paths, the function name takes one argument */
+#define LVGL_LOGE(fmt, ...)         LVGL_LOG(ESP_LOG_ERROR, TAG, "[%s]:" fmt, __func__, ##__VA_ARGS__)
+#define LVGL_LOGI(fmt, ...)         LVGL_LOG(ESP_LOG_INFO, TAG, "[%s]:" fmt, __func__, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LVGL_LOG_H */
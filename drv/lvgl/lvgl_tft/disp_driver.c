@@ -2,53 +2,146 @@
  * @file disp_driver.c
  */
 
+#include <assert.h>
+#include <string.h>
+
 #include "disp_driver.h"
 #include "disp_spi.h"
+#include "../lvgl_helpers.h"
 #include "sdkconfig.h"
 #include "esp_log.h"
+#include "driver/soc.h"
+
+#if LVGL_DISP_ILI9341
+#include "ili9341.h"
+#endif
+#if LVGL_DISP_ILI9488
+#include "ili9488.h"
+#endif
 
 static const char* TAG = "disp_driver";
 
+static void disp_driver_register_builtin(void);
+static inline const disp_driver_t * disp_driver_in_use(void);
+#if LVGL_DISP_NULL
+static void disp_null_init(void);
+static void disp_null_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map);
+#endif
+
+/* Written before the GUI starts, only read afterwards */
+static const disp_driver_t * s_ptDrivers[DISP_DRIVER_MAX];
+static uint32_t s_uiDrivers = 0;
+static const disp_driver_t * s_ptDrv = NULL;
+static bool s_bBuiltin = false;
+
+#if LVGL_DISP_NULL
+/* Drops the pixels, benchmarks against it show what rendering alone costs */
+static const disp_driver_t s_tNullDriver = {
+    .name = "null",
+    .hor_res = LV_HOR_RES_MAX,
+    .ver_res = LV_VER_RES_MAX,
+    .buf_lines = 30,
+    .caps = DISP_DRIVER_FMT_RGB565,
+    .max_spi_hz = 0,
+    .init = disp_null_init,
+    .flush = disp_null_flush,
+};
+#endif
+
+/* LVGL renders in one color format for all panels, a driver has to take it */
+#if LV_COLOR_DEPTH == 1
+#define DISP_DRIVER_FMT_LVGL    DISP_DRIVER_FMT_MONO
+#else
+#define DISP_DRIVER_FMT_LVGL    (DISP_DRIVER_FMT_RGB565 | DISP_DRIVER_FMT_RGB666)
+#endif
+
+bool disp_driver_register(const disp_driver_t * drv)
+{
+    disp_driver_register_builtin();
+
+    if (drv == NULL || drv->name == NULL || drv->init == NULL || drv->flush == NULL)
+    {
+        LOGE("incomplete driver!!");
+        return false;
+    }
+    if ((drv->caps & DISP_DRIVER_FMT_LVGL) == 0)
+    {
+        LOGE("%s does not take LV_COLOR_DEPTH %d!!", drv->name, LV_COLOR_DEPTH);
+        return false;
+    }
+    if (s_uiDrivers >= DISP_DRIVER_MAX)
+    {
+        LOGE("no room for %s, raise DISP_DRIVER_MAX!!", drv->name);
+        return false;
+    }
+
+    s_ptDrivers[s_uiDrivers++] = drv;
+    LOGI("%s %dx%d caps:0x%x spi:%u Hz", drv->name, drv->hor_res, drv->ver_res, drv->caps, drv->max_spi_hz);
+    return true;
+}
+
+bool disp_driver_select(const char * name)
+{
+    disp_driver_register_builtin();
+
+    for (uint32_t i = 0; name && i < s_uiDrivers; i++)
+    {
+        if (strcmp(s_ptDrivers[i]->name, name) == 0)
+        {
+            s_ptDrv = s_ptDrivers[i];
+            LOGI("panel:%s", name);
+            return true;
+        }
+    }
+
+    /* Back to LVGL_DISP_DEFAULT, disp_driver_get() picks it again */
+    s_ptDrv = NULL;
+    const disp_driver_t * ptFallback = disp_driver_get();
+    LOGE("panel:%s not registered, using %s!!", name ? name : "(null)", ptFallback->name);
+    return false;
+}
+
+const disp_driver_t * disp_driver_get(void)
+{
+    if (s_ptDrv == NULL)
+    {
+        disp_driver_register_builtin();
+        for (uint32_t i = 0; i < s_uiDrivers; i++)
+        {
+            if (strcmp(s_ptDrivers[i]->name, LVGL_DISP_DEFAULT) == 0)
+            {
+                s_ptDrv = s_ptDrivers[i];
+                break;
+            }
+        }
+        /* LVGL_DISP_DEFAULT not linked in, any panel beats none */
+        if (s_ptDrv == NULL)
+        {
+            assert(s_uiDrivers > 0);
+            s_ptDrv = s_ptDrivers[0];
+        }
+    }
+    return s_ptDrv;
+}
+
+const disp_driver_t * disp_driver_get_by_index(uint32_t idx)
+{
+    disp_driver_register_builtin();
+
+    return idx < s_uiDrivers ? s_ptDrivers[idx] : NULL;
+}
+
+uint32_t disp_driver_buf_size(void)
+{
+    const disp_driver_t * drv = disp_driver_get();
+
+    return (uint32_t)drv->hor_res * drv->buf_lines;
+}
+
 void *disp_driver_init(void)
 {
     LOGI("Enter >>");
-#if defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9341
-    ili9341_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9481
-    ili9481_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9488
-    ili9488_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ST7789
-    st7789_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ST7796S
-    st7796s_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ST7735S
-    st7735s_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_HX8357
-    hx8357_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9486
-    ili9486_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_SH1107
-    sh1107_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_SSD1306
-    ssd1306_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_FT81X
-    FT81x_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_IL3820
-    il3820_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_RA8875
-    ra8875_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_GC9A01
-   GC9A01_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_JD79653A
-   jd79653a_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_UC8151D
-   uc8151d_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9163C
-    ili9163c_init();
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_PCD8544
-    pcd8544_init();
-#endif
+    disp_driver_get()->init();
 
     // We still use menuconfig for these settings
     // It will be set up during runtime in the future
@@ -79,64 +172,38 @@ void *disp_driver_init(void)
 void disp_driver_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map)
 {
     //LOGI("Enter >>");
-#if defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9341
-    ili9341_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9481
-    ili9481_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9488
-    ili9488_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ST7789
-    st7789_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ST7796S
-    st7796s_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ST7735S
-    st7735s_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_HX8357
-	hx8357_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9486
-    ili9486_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_SH1107
-	sh1107_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_SSD1306
-    ssd1306_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_FT81X
-    FT81x_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_IL3820
-    il3820_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_RA8875
-    ra8875_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_GC9A01
-    GC9A01_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_JD79653A
-    jd79653a_lv_fb_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_UC8151D
-    uc8151d_lv_fb_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9163C
-    ili9163c_flush(drv, area, color_map);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_PCD8544
-    pcd8544_flush(drv, area, color_map);
+#if LVGL_FLUSH_STATS
+    uint32_t uiStart = soc_get_ccount();
+#endif
+
+    const disp_driver_t * ptDrv = disp_driver_in_use();
+
+    ptDrv->flush(drv, area, color_map);
+
+    /* ILI9341 and ILI9488 send their colors with DISP_SPI_SIGNAL_FLUSH, lv_disp_flush_ready()
+     * is called from the SPI ISR once the last chunk is out, so LVGL renders into the other buffer meanwhile.
+     * Their descriptors carry DISP_DRIVER_CAP_FLUSH_READY */
+    if ((ptDrv->caps & DISP_DRIVER_CAP_FLUSH_READY) == 0)
+    {
+        /*IMPORTANT!!!
+         *Inform the graphics library that you are ready with the flushing*/
+        lv_disp_flush_ready(drv);
+    }
+
+#if LVGL_FLUSH_STATS
+    lvgl_flush_stats_add(soc_get_ccount() - uiStart);
 #endif
-    /*IMPORTANT!!!
-     *Inform the graphics library that you are ready with the flushing*/
-    lv_disp_flush_ready(drv);
 }
 
 void disp_driver_rounder(lv_disp_drv_t * disp_drv, lv_area_t * area)
 {
     //LOGI("Enter >>");
-#if defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_SSD1306
-    ssd1306_rounder(disp_drv, area);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_SH1107
-    sh1107_rounder(disp_drv, area);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_IL3820
-    il3820_rounder(disp_drv, area);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_JD79653A
-    jd79653a_lv_rounder_cb(disp_drv, area);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_UC8151D
-    uc8151d_lv_rounder_cb(disp_drv, area);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_PCD8544
-    pcd8544_rounder(disp_drv, area);
-#endif
+    const disp_driver_t * ptDrv = disp_driver_in_use();
+
+    if (ptDrv->rounder)
+    {
+        ptDrv->rounder(disp_drv, area);
+    }
     //LOGI("End <<");
 }
 
@@ -144,17 +211,67 @@ void disp_driver_set_px(lv_disp_drv_t * disp_drv, uint8_t * buf, lv_coord_t buf_
     lv_color_t color, lv_opa_t opa)
 {
     //LOGI("Enter >>");
-#if defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_SSD1306
-    ssd1306_set_px_cb(disp_drv, buf, buf_w, x, y, color, opa);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_SH1107
-    sh1107_set_px_cb(disp_drv, buf, buf_w, x, y, color, opa);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_IL3820
-    il3820_set_px_cb(disp_drv, buf, buf_w, x, y, color, opa);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_JD79653A
-    jd79653a_lv_set_fb_cb(disp_drv, buf, buf_w, x, y, color, opa);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_UC8151D
-    uc8151d_lv_set_fb_cb(disp_drv, buf, buf_w, x, y, color, opa);
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_PCD8544
-   pcd8544_set_px_cb(disp_drv, buf, buf_w, x, y, color, opa);
+    const disp_driver_t * ptDrv = disp_driver_in_use();
+
+    if (ptDrv->set_px)
+    {
+        ptDrv->set_px(disp_drv, buf, buf_w, x, y, color, opa);
+    }
+}
+
+void disp_driver_sleep(bool enter)
+{
+    if (disp_driver_get()->sleep)
+    {
+        s_ptDrv->sleep(enter);
+    }
+}
+
+void disp_driver_set_orientation(uint8_t orientation)
+{
+    if (disp_driver_get()->set_orientation)
+    {
+        s_ptDrv->set_orientation(orientation);
+    }
+}
+
+/* The callbacks LVGL calls per area or pixel, s_ptDrv is only NULL before the first
+ * disp_driver_get() or when flushing without disp_driver_init() */
+static inline const disp_driver_t * disp_driver_in_use(void)
+{
+    return s_ptDrv ? s_ptDrv : disp_driver_get();
+}
+
+/* Panels linked into the image hand in their descriptors, first call only */
+static void disp_driver_register_builtin(void)
+{
+    if (s_bBuiltin)
+    {
+        return;
+    }
+    s_bBuiltin = true;
+
+#if LVGL_DISP_ILI9341
+    ili9341_register();
+#endif
+#if LVGL_DISP_ILI9488
+    ili9488_register();
 #endif
+#if LVGL_DISP_NULL
+    disp_driver_register(&s_tNullDriver);
+#endif
+}
+
+#if LVGL_DISP_NULL
+static void disp_null_init(void)
+{
+    LOGI("pixels are dropped");
 }
+
+static void disp_null_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map)
+{
+    (void) drv;
+    (void) area;
+    (void) color_map;
+}
+#endif
@@ -12,60 +12,67 @@ extern "C" {
 /*********************
  *      INCLUDES
  *********************/
-#include "lvgl.h"
+#include <stdbool.h>
+#include <stdint.h>
 
-#define CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9341
-
-#if defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9341
-#include "ili9341.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9481
-#include "ili9481.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9488
-#include "ili9488.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ST7789
-#include "st7789.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ST7796S
-#include "st7796s.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ST7735S
-#include "st7735s.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_HX8357
-#include "hx8357.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9486
-#include "ili9486.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_SH1107
-#include "sh1107.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_SSD1306
-#include "ssd1306.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_FT81X
-#include "FT81x.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_IL3820
-#include "il3820.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_RA8875
-#include "ra8875.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_GC9A01
-#include "GC9A01.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_JD79653A
-#include "jd79653a.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_UC8151D
-#include "uc8151d.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9163C
-#include "ili9163c.h"
-#elif defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_PCD8544
-#include "pcd8544.h"
-#endif
+#include "lvgl.h"
 
 /*********************
  *      DEFINES
  *********************/
+/* Pixel formats the panel is sent */
+#define DISP_DRIVER_FMT_RGB565          (1 << 0)
+#define DISP_DRIVER_FMT_RGB666          (1 << 1)    /* expanded from LVGL's RGB565 in the flush */
+#define DISP_DRIVER_FMT_MONO            (1 << 2)    /* 1 bit per pixel, needs rounder and set_px */
+
+/* The flush calls lv_disp_flush_ready() itself, e.g. from the SPI ISR with DISP_SPI_SIGNAL_FLUSH */
+#define DISP_DRIVER_CAP_FLUSH_READY     (1 << 8)
+
+/* Registered drivers at most, the built-in ones included */
+#define DISP_DRIVER_MAX                 (4)
 
 /**********************
  *      TYPEDEFS
  **********************/
+/* A panel driver as the display path sees it. Callbacks that do not apply are NULL */
+typedef struct {
+    const char * name;                  /* matched against the "panel" entry of the stored config */
+    lv_coord_t hor_res;                 /* in CONFIG_LV_DISPLAY_ORIENTATION */
+    lv_coord_t ver_res;
+    uint16_t buf_lines;                 /* lines of hor_res pixels per draw buffer */
+    uint32_t caps;                      /* DISP_DRIVER_FMT_* | DISP_DRIVER_CAP_* */
+    uint32_t max_spi_hz;                /* fastest SPI clock the controller takes, 0 when not on SPI */
+
+    void (*init)(void);
+    void (*flush)(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map);
+    void (*rounder)(lv_disp_drv_t * drv, lv_area_t * area);
+    void (*set_px)(lv_disp_drv_t * drv, uint8_t * buf, lv_coord_t buf_w, lv_coord_t x, lv_coord_t y,
+        lv_color_t color, lv_opa_t opa);
+    void (*sleep)(bool enter);
+    void (*set_orientation)(uint8_t orientation);
+} disp_driver_t;
 
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
 
+/* Add a driver to the ones disp_driver_select() picks from. Drivers linked into the image
+ * register themselves, see LVGL_DISP_* in lvgl_helpers.h. drv must stay valid */
+bool disp_driver_register(const disp_driver_t * drv);
+
+/* Choose the driver of the panel by name, before lvgl_driver_init(). An unknown name selects
+ * LVGL_DISP_DEFAULT, or the first registered driver without it, and returns false */
+bool disp_driver_select(const char * name);
+
+/* The driver in use, LVGL_DISP_DEFAULT until one is selected */
+const disp_driver_t * disp_driver_get(void);
+
+/* Registered driver number idx, NULL past the last one. For listing them and for benchmarks */
+const disp_driver_t * disp_driver_get_by_index(uint32_t idx);
+
+/* Pixels of one draw buffer of the driver in use */
+uint32_t disp_driver_buf_size(void);
+
 /* Initialize display */
 void *disp_driver_init(void);
 
@@ -79,6 +86,12 @@ void disp_driver_rounder(lv_disp_drv_t * disp_drv, lv_area_t * area);
 void disp_driver_set_px(lv_disp_drv_t * disp_drv, uint8_t * buf, lv_coord_t buf_w, lv_coord_t x, lv_coord_t y,
     lv_color_t color, lv_opa_t opa);
 
+/* Put the panel into sleep or wake it up, a no-op for drivers without sleep */
+void disp_driver_sleep(bool enter);
+
+/* Scan direction of the panel. hor_res and ver_res of LVGL stay the caller's business */
+void disp_driver_set_orientation(uint8_t orientation);
+
 /**********************
  *      MACROS
  **********************/
@@ -17,10 +17,12 @@
 #define TAG "disp_spi"
 
 #include <string.h>
+#include <assert.h>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #include <freertos/task.h>
+#include <freertos/queue.h>
 
 #include "lvgl.h"
 
@@ -28,48 +30,54 @@
 #include "disp_driver.h"
 
 #include "../lvgl_helpers.h"
+#include "../lvgl_log.h"
 #include "../lvgl_spi_conf.h"
 
 /******************************************************************************
- * Notes about DMA spi_transaction_ext_t structure pooling
+ * Notes about spi transaction structure pooling
  * 
- * An xQueue is used to hold a pool of reusable SPI spi_transaction_ext_t 
- * structures that get used for all DMA SPI transactions. While an xQueue may 
- * seem like overkill it is an already built-in RTOS feature that comes at 
- * little cost. xQueues are also ISR safe if it ever becomes necessary to 
- * access the pool in the ISR callback.
+ * An xQueue is used to hold a pool of reusable disp_spi_trans_t structures
+ * that get used for all queued SPI transactions. While an xQueue may seem
+ * like overkill it is an already built-in RTOS feature that comes at little
+ * cost. xQueues are also ISR safe, the SPI ISR takes the next pending
+ * transaction and recycles the finished one without waking the GUI task.
  * 
- * When a DMA request is sent, a transaction structure is removed from the 
- * pool, filled out, and passed off to the esp32 SPI driver. Later, when 
- * servicing pending SPI transaction results, the transaction structure is 
- * recycled back into the pool for later reuse. This matches the DMA SPI 
- * transaction life cycle requirements of the esp32 SPI driver.
+ * When a queued request is sent, a transaction structure is removed from the 
+ * pool, filled out, and appended to the pending queue. The ESP8266 HSPI has no
+ * DMA, so the SPI_TRANS_DONE_EVENT of lvgl_helpers refills the 64 byte FIFO
+ * chunk by chunk. When the last chunk of a transaction is out, the structure
+ * is recycled back into the pool and the next pending one is started from
+ * the same ISR.
  * 
- * When polling or synchronously sending SPI requests, and as required by the 
- * esp32 SPI driver, all pending DMA transactions are first serviced. Then the 
- * polling SPI request takes place. 
+ * A queued transaction may carry DISP_SPI_DC_CMD or DISP_SPI_DC_DATA, the DC
+ * line is then switched right before it is started. That happens between two
+ * transactions in the ISR chain, so command and parameter bytes can be queued
+ * back to back without waiting for the bus in between.
  * 
- * When sending an asynchronous DMA SPI request, if the pool is empty, some 
- * small percentage of pending transactions are first serviced before sending 
- * any new DMA SPI transactions. Not too many and not too few as this balance 
- * controls DMA transaction latency.
+ * When polling or synchronously sending SPI requests, all pending
+ * transactions are first serviced. Then the polling SPI request takes place.
+ * 
+ * When sending a queued SPI request, if the pool is empty, some small
+ * percentage of pending transactions are first serviced before sending 
+ * any new SPI transactions. Not too many and not too few as this balance 
+ * controls transaction latency.
  * 
  * It is therefore not the design that all pending transactions must be 
- * serviced and placed back into the pool with DMA SPI requests - that 
+ * serviced and placed back into the pool with queued SPI requests - that 
  * will happen eventually. The pool just needs to contain enough to float some 
- * number of in-flight SPI requests to speed up the overall DMA SPI data rate 
- * and reduce transaction latency. If however a display driver uses some 
- * polling SPI requests or calls disp_wait_for_pending_transactions() directly,
- * the pool will reach the full state more often and speed up DMA queuing.
+ * number of in-flight SPI requests to keep the bus busy and reduce
+ * transaction latency. If however a display driver uses some polling SPI
+ * requests or calls disp_wait_for_pending_transactions() directly, the pool
+ * will reach the full state more often and speed up queuing.
  * 
  *****************************************************************************/
 
 /*********************
  *      DEFINES
  *********************/
-#define SPI_TRANSACTION_POOL_SIZE                   50	/* maximum number of DMA transactions simultaneously in-flight */
+#define SPI_TRANSACTION_POOL_SIZE                   50	/* maximum number of transactions simultaneously in-flight */
 
-/* DMA Transactions to reserve before queueing additional DMA transactions. A 1/10th seems to be a good balance. Too many (or all) and it will increase latency. */
+/* Transactions to reserve before queueing additional transactions. A 1/10th seems to be a good balance. Too many (or all) and it will increase latency. */
 #define SPI_TRANSACTION_POOL_RESERVE_PERCENTAGE     10
 #if SPI_TRANSACTION_POOL_SIZE >= SPI_TRANSACTION_POOL_RESERVE_PERCENTAGE
 #define SPI_TRANSACTION_POOL_RESERVE                (SPI_TRANSACTION_POOL_SIZE / SPI_TRANSACTION_POOL_RESERVE_PERCENTAGE)	
@@ -77,17 +85,40 @@
 #define SPI_TRANSACTION_POOL_RESERVE                1	/* defines minimum size */
 #endif
 
+/* Queued payloads up to this size are copied, so callers may pass stack buffers */
+#define SPI_TRANSACTION_INLINE_SIZE                 16
+
 /**********************
  *      TYPEDEFS
  **********************/
+typedef struct {
+    const uint8_t *data;
+    size_t length;
+    disp_spi_send_flag_t flags;
+    lv_disp_drv_t *disp_drv;                        /* flushed display, for DISP_SPI_SIGNAL_FLUSH */
+    disp_spi_done_cb_t done_cb;                     /* only from disp_spi_queue_data() */
+    void *done_arg;
+    uint8_t inline_buf[SPI_TRANSACTION_INLINE_SIZE];
+} disp_spi_trans_t;
 
 /**********************
  *  STATIC PROTOTYPES
  **********************/
+static disp_spi_trans_t *disp_spi_trans_get(void);
+static void disp_spi_queue(disp_spi_trans_t *trans);
+static bool disp_spi_trans_done(void *arg);
+static size_t disp_spi_addr_len(disp_spi_send_flag_t flags);
+static bool disp_spi_trans_start(disp_spi_trans_t *trans);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+static disp_spi_trans_t trans_pool_buf[SPI_TRANSACTION_POOL_SIZE];
+static QueueHandle_t TransactionPool = NULL;
+static QueueHandle_t TransactionPending = NULL;
+static SemaphoreHandle_t TransactionDone = NULL;
+static volatile bool trans_in_flight = false;
+static bool (*flush_done_cb)(void) = NULL;
 
 /**********************
  *      MACROS
@@ -97,15 +128,127 @@
  *   GLOBAL FUNCTIONS
  **********************/
 
- void disp_spi_transaction(const uint8_t *data, size_t length, disp_spi_send_flag_t flags, 
+void disp_spi_init(void)
+{
+    LOGI("Enter >>");
+
+    TransactionPool = xQueueCreate(SPI_TRANSACTION_POOL_SIZE, sizeof(disp_spi_trans_t *));
+    TransactionPending = xQueueCreate(SPI_TRANSACTION_POOL_SIZE, sizeof(disp_spi_trans_t *));
+    TransactionDone = xSemaphoreCreateBinary();
+    assert(TransactionPool != NULL && TransactionPending != NULL && TransactionDone != NULL);
+
+    for (size_t i = 0; i < SPI_TRANSACTION_POOL_SIZE; i++)
+    {
+        disp_spi_trans_t *trans = &trans_pool_buf[i];
+        xQueueSend(TransactionPool, &trans, portMAX_DELAY);
+    }
+
+    LOGI("End <<");
+}
+
+void disp_spi_transaction(const uint8_t *data, size_t length, disp_spi_send_flag_t flags, 
                                             uint8_t *out, uint64_t addr, uint8_t dummy_bits)
 {    
-    lvgl_spi_transmit(SPI_SEND, data, length);
+    if ((flags & DISP_SPI_RECEIVE) || dummy_bits)
+    {
+        /* HSPI is driven write only by lvgl_helpers, nothing here reads the panel back */
+        LVGL_LOGE("receive/dummy phase not supported!! flags:%#x dummy_bits:%u", flags, dummy_bits);
+        return;
+    }
+
+    /* The address goes out big endian in front of the data, like the address phase would */
+    uint8_t addr_buf[4];
+    size_t addr_len = disp_spi_addr_len(flags);
+    for (size_t i = 0; i < addr_len; i++)
+    {
+        addr_buf[i] = (uint8_t)(addr >> (8 * (addr_len - 1 - i)));
+    }
+
+    if (flags & (DISP_SPI_SEND_POLLING | DISP_SPI_SEND_SYNCHRONOUS))
+    {
+        disp_wait_for_pending_transactions();
+
+        lvgl_spi_transmit(SPI_SEND, addr_buf, addr_len);
+        lvgl_spi_transmit(SPI_SEND, data, length);
+
+        if (flags & (DISP_SPI_SEND_SYNCHRONOUS | DISP_SPI_SIGNAL_FLUSH))
+        {
+            lvgl_spi_wait_idle();
+        }
+        if (flags & DISP_SPI_SIGNAL_FLUSH)
+        {
+            lv_disp_flush_ready(_lv_refr_get_disp_refreshing()->driver);
+        }
+        return;
+    }
+
+    /* DISP_SPI_SEND_QUEUED */
+    disp_spi_trans_t *trans = disp_spi_trans_get();
+    trans->flags = flags;
+    trans->disp_drv = (flags & DISP_SPI_SIGNAL_FLUSH) ? _lv_refr_get_disp_refreshing()->driver : NULL;
+    trans->done_cb = NULL;
+
+    if (addr_len + length <= SPI_TRANSACTION_INLINE_SIZE)
+    {
+        memcpy(trans->inline_buf, addr_buf, addr_len);
+        memcpy(trans->inline_buf + addr_len, data, length);
+        trans->data = trans->inline_buf;
+        trans->length = addr_len + length;
+    }
+    else
+    {
+        if (addr_len)
+        {
+            /* Address first in its own transaction with the caller's DC and mode
+             * flags, only the data transaction signals the flush */
+            disp_spi_trans_t *addr_trans = trans;
+            addr_trans->flags = (flags & ~DISP_SPI_SIGNAL_FLUSH) | DISP_SPI_SEND_QUEUED;
+            addr_trans->disp_drv = NULL;
+            memcpy(addr_trans->inline_buf, addr_buf, addr_len);
+            addr_trans->data = addr_trans->inline_buf;
+            addr_trans->length = addr_len;
+            disp_spi_queue(addr_trans);
+
+            trans = disp_spi_trans_get();
+            trans->flags = flags;
+            trans->disp_drv = (flags & DISP_SPI_SIGNAL_FLUSH) ? _lv_refr_get_disp_refreshing()->driver : NULL;
+            trans->done_cb = NULL;
+        }
+        trans->data = data;
+        trans->length = length;
+    }
+
+    disp_spi_queue(trans);
+}
+
+void disp_spi_queue_data(const uint8_t *data, size_t length, disp_spi_send_flag_t flags,
+    disp_spi_done_cb_t done_cb, void *arg)
+{
+    disp_spi_trans_t *trans = disp_spi_trans_get();
+    trans->flags = flags & ~(DISP_SPI_SEND_POLLING | DISP_SPI_SEND_SYNCHRONOUS);
+    trans->disp_drv = (flags & DISP_SPI_SIGNAL_FLUSH) ? _lv_refr_get_disp_refreshing()->driver : NULL;
+    trans->done_cb = done_cb;
+    trans->done_arg = arg;
+    trans->data = data;
+    trans->length = length;
+
+    disp_spi_queue(trans);
 }
 
 void disp_wait_for_pending_transactions(void)
 {
-    return;
+    /* Every queued transaction comes back to the pool once it is on the wire */
+    while (uxQueueMessagesWaiting(TransactionPool) < SPI_TRANSACTION_POOL_SIZE)
+    {
+        xSemaphoreTake(TransactionDone, portMAX_DELAY);
+    }
+
+    lvgl_spi_wait_idle();
+}
+
+void disp_spi_set_flush_done_cb(bool (*cb)(void))
+{
+    flush_done_cb = cb;
 }
 
 void disp_spi_acquire(void)
@@ -122,3 +265,122 @@ void disp_spi_release(void)
  *   STATIC FUNCTIONS
  **********************/
 
+static disp_spi_trans_t *disp_spi_trans_get(void)
+{
+    disp_spi_trans_t *trans = NULL;
+
+    if (xQueueReceive(TransactionPool, &trans, 0) != pdTRUE)
+    {
+        /* Pool exhausted, service SPI_TRANSACTION_POOL_RESERVE pending transactions first */
+        while (uxQueueMessagesWaiting(TransactionPool) < SPI_TRANSACTION_POOL_RESERVE)
+        {
+            xSemaphoreTake(TransactionDone, portMAX_DELAY);
+        }
+        xQueueReceive(TransactionPool, &trans, portMAX_DELAY);
+    }
+
+    return trans;
+}
+
+static void disp_spi_queue(disp_spi_trans_t *trans)
+{
+    xQueueSend(TransactionPending, &trans, portMAX_DELAY);
+
+    if (!trans_in_flight)
+    {
+        /* The tail of a polling transmit may still be shifting out, DC must not move under it */
+        while (SPI1.cmd.usr);
+    }
+
+    /* Kick the bus if the ISR chain is not running, otherwise it picks this one up */
+    bool woken = false;
+    portENTER_CRITICAL();
+    if (!trans_in_flight && xQueueReceive(TransactionPending, &trans, 0) == pdTRUE)
+    {
+        trans_in_flight = true;
+        woken = disp_spi_trans_start(trans);
+    }
+    portEXIT_CRITICAL();
+
+    if (woken)
+    {
+        taskYIELD();
+    }
+}
+
+/* Runs in the SPI ISR when the last chunk of a transaction is out. The woken flags of
+ * everything called here are collected, spi_event_callback yields once for all of them */
+static bool IRAM_ATTR disp_spi_trans_done(void *arg)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    disp_spi_trans_t *trans = (disp_spi_trans_t *)arg;
+
+    if (trans->done_cb && trans->done_cb(trans->done_arg))
+    {
+        xHigherPriorityTaskWoken = pdTRUE;
+    }
+
+    if (trans->flags & DISP_SPI_SIGNAL_FLUSH)
+    {
+        lv_disp_flush_ready(trans->disp_drv);
+        if (flush_done_cb && flush_done_cb())
+        {
+            xHigherPriorityTaskWoken = pdTRUE;
+        }
+    }
+
+    xQueueSendFromISR(TransactionPool, &trans, &xHigherPriorityTaskWoken);
+
+    if (xQueueReceiveFromISR(TransactionPending, &trans, &xHigherPriorityTaskWoken) == pdTRUE)
+    {
+        if (disp_spi_trans_start(trans))
+        {
+            xHigherPriorityTaskWoken = pdTRUE;
+        }
+    }
+    else
+    {
+        trans_in_flight = false;
+    }
+
+    xSemaphoreGiveFromISR(TransactionDone, &xHigherPriorityTaskWoken);
+
+    return xHigherPriorityTaskWoken == pdTRUE;
+}
+
+static size_t disp_spi_addr_len(disp_spi_send_flag_t flags)
+{
+    if (flags & DISP_SPI_ADDRESS_8)
+    {
+        return 1;
+    }
+    else if (flags & DISP_SPI_ADDRESS_16)
+    {
+        return 2;
+    }
+    else if (flags & DISP_SPI_ADDRESS_24)
+    {
+        return 3;
+    }
+    else if (flags & DISP_SPI_ADDRESS_32)
+    {
+        return 4;
+    }
+    return 0;
+}
+
+/* Set DC for the transaction and start it, the bus is idle here. Returns true when
+ * an empty transaction completed at once and woke a task */
+static bool IRAM_ATTR disp_spi_trans_start(disp_spi_trans_t *trans)
+{
+    if (trans->flags & DISP_SPI_DC_CMD)
+    {
+        GPIO.out_w1tc = 1 << CONFIG_LV_DISP_PIN_DC;
+    }
+    else if (trans->flags & DISP_SPI_DC_DATA)
+    {
+        GPIO.out_w1ts = 1 << CONFIG_LV_DISP_PIN_DC;
+    }
+
+    return lvgl_spi_transmit_async_from_isr(trans->data, trans->length, disp_spi_trans_done, trans);
+}
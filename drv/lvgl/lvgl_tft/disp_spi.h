@@ -44,8 +44,14 @@ typedef enum _disp_spi_send_flag_t {
     DISP_SPI_MODE_QIO           = 0x00000800, 
     DISP_SPI_MODE_DIOQIO_ADDR   = 0x00001000, 
 	DISP_SPI_VARIABLE_DUMMY		= 0x00002000,
+    DISP_SPI_DC_CMD             = 0x00004000, /* DC low before the transaction goes out */
+    DISP_SPI_DC_DATA            = 0x00008000, /* DC high before the transaction goes out */
 } disp_spi_send_flag_t;
 
+/* Called from the SPI ISR once a queued transaction is on the wire and its buffer may be reused.
+   Returns true when it woke a higher priority task, never yields itself */
+typedef bool (*disp_spi_done_cb_t)(void *arg);
+
 
 /**********************
  * GLOBAL PROTOTYPES
@@ -61,10 +67,23 @@ typedef enum _disp_spi_send_flag_t {
 	When DMA reading (even in polling mode) the ESP32 always read in 4-byte chunks even if less is requested.
 	Extra space will be zero filled. Always ensure the out buffer is large enough to hold at least 4 bytes!
 */
+/* Create the transaction pool, call once after lvgl_spi_init() */
+void disp_spi_init(void);
+
 void disp_spi_transaction(const uint8_t *data, size_t length,
     disp_spi_send_flag_t flags, uint8_t *out, uint64_t addr, uint8_t dummy_bits);
 
+/* Queue data as is (no address, no copy) and call done_cb once it is out, for drivers that
+   produce their data chunk by chunk into a ring of buffers */
+void disp_spi_queue_data(const uint8_t *data, size_t length, disp_spi_send_flag_t flags,
+    disp_spi_done_cb_t done_cb, void *arg);
+
 void disp_wait_for_pending_transactions(void);
+
+/* cb is called from the SPI ISR after lv_disp_flush_ready() of a queued flush,
+   to wake the task running lv_timer_handler(). Returns true like disp_spi_done_cb_t */
+void disp_spi_set_flush_done_cb(bool (*cb)(void));
+
 void disp_spi_acquire(void);
 void disp_spi_release(void);
 
@@ -0,0 +1,102 @@
+/**
+ * @file disp_spi_9bit.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "disp_spi_9bit.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void disp_spi_9bit_enc_init(disp_spi_9bit_enc_t *enc, uint8_t *out)
+{
+    enc->out = out;
+    enc->acc = 0;
+    enc->acc_bits = 0;
+    enc->bits = 0;
+}
+
+void disp_spi_9bit_enc_put(disp_spi_9bit_enc_t *enc, const uint8_t *data, size_t len, bool dc)
+{
+    uint32_t acc = enc->acc;
+    uint32_t acc_bits = enc->acc_bits;
+    uint8_t *out = enc->out;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        /* At most 7 bits are left over, so 16 bits of accumulator are enough */
+        acc = (acc << 9) | ((uint32_t)dc << 8) | data[i];
+        acc_bits += 9;
+
+        acc_bits -= 8;
+        *out++ = (uint8_t)(acc >> acc_bits);
+        if (acc_bits == 8)
+        {
+            acc_bits = 0;
+            *out++ = (uint8_t)acc;
+        }
+        acc &= (1UL << acc_bits) - 1;
+    }
+
+    enc->acc = acc;
+    enc->acc_bits = acc_bits;
+    enc->out = out;
+    enc->bits += len * 9;
+}
+
+size_t disp_spi_9bit_enc_finish(disp_spi_9bit_enc_t *enc)
+{
+    if (enc->acc_bits)
+    {
+        *enc->out++ = (uint8_t)(enc->acc << (8 - enc->acc_bits));
+        enc->acc = 0;
+        enc->acc_bits = 0;
+    }
+
+    return enc->bits;
+}
+
+size_t disp_spi_9bit_decode(const uint8_t *in, size_t bits, uint8_t *out, bool *dc)
+{
+    size_t count = bits / 9;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t pos = i * 9;
+        /* A 9-bit unit always spans exactly two input bytes */
+        uint32_t word = ((uint32_t)in[pos / 8] << 8) | in[pos / 8 + 1];
+        uint32_t unit = (word >> (7 - (pos % 8))) & 0x1FF;
+
+        out[i] = (uint8_t)unit;
+        if (dc)
+        {
+            dc[i] = (unit >> 8) & 1;
+        }
+    }
+
+    return count;
+}
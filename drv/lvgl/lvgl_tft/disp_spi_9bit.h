@@ -0,0 +1,65 @@
+/**
+ * @file disp_spi_9bit.h
+ *
+ * Bit packing of the 3-line 9-bit serial interface (ILI9341 and friends):
+ * every byte goes out as a D/C bit followed by its 8 data bits, MSB first.
+ * No SDK dependencies, the same code packs on target and unpacks captures.
+ */
+
+#ifndef DISP_SPI_9BIT_H
+#define DISP_SPI_9BIT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+/* 8 bytes pack into exactly 9, so a stream cut every 8 bytes stays byte aligned */
+#define DISP_SPI_9BIT_GROUP         8
+
+/* Size of the packed output for len bytes */
+#define DISP_SPI_9BIT_BYTES(len)    (((len) * 9 + 7) / 8)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    uint8_t *out;       /* next output byte */
+    uint32_t acc;       /* bits not written out yet, right aligned */
+    uint32_t acc_bits;
+    size_t bits;        /* bits packed so far */
+} disp_spi_9bit_enc_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+void disp_spi_9bit_enc_init(disp_spi_9bit_enc_t *enc, uint8_t *out);
+
+/* Append len bytes, dc false for command bytes and true for parameters/pixels */
+void disp_spi_9bit_enc_put(disp_spi_9bit_enc_t *enc, const uint8_t *data, size_t len, bool dc);
+
+/* Flush the partial last byte (zero padded), returns the number of bits to clock out */
+size_t disp_spi_9bit_enc_finish(disp_spi_9bit_enc_t *enc);
+
+/* Unpack bits of a 9-bit stream into bytes, dc gets one D/C bit per byte when not NULL.
+ * Returns the number of whole bytes, a trailing partial unit is ignored. */
+size_t disp_spi_9bit_decode(const uint8_t *in, size_t bits, uint8_t *out, bool *dc);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*DISP_SPI_9BIT_H*/
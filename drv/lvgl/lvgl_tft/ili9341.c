@@ -6,8 +6,12 @@
 /*********************
  *      INCLUDES
  *********************/
+#include <string.h>
+
 #include "ili9341.h"
 #include "disp_spi.h"
+#include "disp_spi_9bit.h"
+#include "../lvgl_log.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
@@ -18,6 +22,23 @@
  *********************/
  #define TAG "ILI9341"
 
+/*Bytes packed per 9-bit load, 56 bytes fill LVGL_SPI_MAX_BITS exactly*/
+#define ILI9341_9BIT_CHUNK  (LVGL_SPI_MAX_BITS / 9)
+
+/*The colors go out as LVGL rendered them, RGB565 has to be MSB first in memory already*/
+#if LVGL_DISP_ILI9341 && LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP == 0
+#error "ILI9341 takes RGB565 MSB first, set LV_COLOR_16_SWAP (CONFIG_LV_COLOR_16_SWAP with CONFIG_LV_CONF_SKIP)"
+#endif
+
+/*Resolution in CONFIG_LV_DISPLAY_ORIENTATION, 2 and 3 are landscape*/
+#if CONFIG_LV_DISPLAY_ORIENTATION < 2
+#define ILI9341_HOR_RES     (240)
+#define ILI9341_VER_RES     (320)
+#else
+#define ILI9341_HOR_RES     (320)
+#define ILI9341_VER_RES     (240)
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -29,18 +50,53 @@ typedef struct {
     uint8_t databytes; //No of data in data; bit 7 = delay after set; 0xFF = end of cmds.
 } lcd_init_cmd_t;
 
+/*Last column/page window sent to the LCD, as the raw CASET/PASET parameter bytes*/
+typedef struct {
+    uint8_t col[4];
+    uint8_t page[4];
+    bool valid;
+} ili9341_window_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
 static void ili9341_set_orientation(uint8_t orientation);
+static void ili9341_sleep(bool enter);
 
 static void ili9341_send_cmd(uint8_t cmd);
 static void ili9341_send_data(void * data, uint16_t length);
-static void ili9341_send_color(void * data, uint16_t length);
+static void ili9341_set_window(const lv_area_t * area);
+static void ili9341_queue_cmd(uint8_t cmd, const uint8_t * data, size_t length);
+#if ILI9341_3WIRE
+static void ili9341_send_9bit(const uint8_t * data, uint32_t length, bool dc);
+#else
+static void ili9341_send_color(void * data, uint32_t length);
+#endif
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+static ili9341_window_t s_tWindow;
+
+static const disp_driver_t ili9341_driver = {
+    .name = "ili9341",
+    .hor_res = ILI9341_HOR_RES,
+    .ver_res = ILI9341_VER_RES,
+    .buf_lines = 30,
+    .caps = DISP_DRIVER_FMT_RGB565 | DISP_DRIVER_CAP_FLUSH_READY,
+    .max_spi_hz = 40 * 1000 * 1000,
+    .init = ili9341_init,
+    .flush = ili9341_flush,
+    .sleep = ili9341_sleep,
+    .set_orientation = ili9341_set_orientation,
+};
+
+#if ILI9341_3WIRE
+/*One FIFO load of packed 9-bit units, spi_trans() wants it word aligned*/
+static uint32_t ili9341_9bit_buf[(LVGL_SPI_MAX_BITS + 31) / 32];
+static disp_spi_9bit_enc_t ili9341_burst;
+#endif
+
  #if 1
 lcd_init_cmd_t ili_init_cmds[]={
 	{0xCF, {0x00, 0x83, 0X30}, 3},
@@ -109,6 +165,11 @@ lcd_init_cmd_t ili_init_cmds[]={
  *   GLOBAL FUNCTIONS
  **********************/
 
+void ili9341_register(void)
+{
+    disp_driver_register(&ili9341_driver);
+}
+
 void ili9341_init(void)
 {
     LOGI("Enter >>");
@@ -118,14 +179,16 @@ void ili9341_init(void)
     io_conf.intr_type = GPIO_INTR_DISABLE;
     //set as output mode
     io_conf.mode = GPIO_MODE_OUTPUT;
-    //bit mask of the pins that you want to set,e.g.GPIO15/16
-    io_conf.pin_bit_mask = (1ULL << ILI9341_DC);
     //disable pull-down mode
     io_conf.pull_down_en = 0;
     //disable pull-up mode
     io_conf.pull_up_en = 0;
+#if !ILI9341_3WIRE
+    //bit mask of the pins that you want to set,e.g.GPIO15/16
+    io_conf.pin_bit_mask = (1ULL << ILI9341_DC);
     //configure GPIO with the given settings
     gpio_config(&io_conf);
+#endif
 
 #if ILI9341_USE_RST
     io_conf.pull_up_en = 0;
@@ -171,89 +234,185 @@ void ili9341_init(void)
 
 void ili9341_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map)
 {
-    //LOGI("Enter >>");
-	uint8_t data[4];
-
-	/*Column addresses*/
-	ili9341_send_cmd(0x2A);
-	data[0] = (area->x1 >> 8) & 0xFF;
-	data[1] = area->x1 & 0xFF;
-	data[2] = (area->x2 >> 8) & 0xFF;
-	data[3] = area->x2 & 0xFF;
-	ili9341_send_data(data, 4);
-
-	/*Page addresses*/
-	ili9341_send_cmd(0x2B);
-	data[0] = (area->y1 >> 8) & 0xFF;
-	data[1] = area->y1 & 0xFF;
-	data[2] = (area->y2 >> 8) & 0xFF;
-	data[3] = area->y2 & 0xFF;
-	ili9341_send_data(data, 4);
+    //LVGL_LOGI("Enter >>");
+	ili9341_set_window(area);
 
-	/*Memory write*/
-	ili9341_send_cmd(0x2C);
 	uint32_t size = lv_area_get_width(area) * lv_area_get_height(area);
+#if ILI9341_3WIRE
+	/*Synchronous, see ILI9341_3WIRE: the last load has to be out before the buffer is released*/
+	ili9341_send_9bit((const uint8_t *)color_map, size * 2, true);
+	lvgl_spi_wait_idle();
+	lv_disp_flush_ready(drv);
+#else
 	ili9341_send_color((void*)color_map, size * 2);
+#endif
     
-    //LOGI("End <<");
+    //LVGL_LOGI("End <<");
 }
 
 void ili9341_sleep_in()
 {
-    LOGI("Enter >>");
+    LVGL_LOGI("Enter >>");
 	uint8_t data[] = {0x08};
 	ili9341_send_cmd(0x10);
 	ili9341_send_data(&data, 1);
     
-    LOGI("End <<");
+    LVGL_LOGI("End <<");
 }
 
 void ili9341_sleep_out()
 {
-    LOGI("Enter >>");
+    LVGL_LOGI("Enter >>");
 	uint8_t data[] = {0x08};
 	ili9341_send_cmd(0x11);
 	ili9341_send_data(&data, 1);
     
-    LOGI("End <<");
+    LVGL_LOGI("End <<");
 }
 
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 
+static void ili9341_sleep(bool enter)
+{
+    if (enter)
+    {
+        ili9341_sleep_in();
+    }
+    else
+    {
+        ili9341_sleep_out();
+    }
+}
+
 
 static void ili9341_send_cmd(uint8_t cmd)
 {
+    /*Raw commands may move the window behind the cache's back (init table, sleep), send it again*/
+    s_tWindow.valid = false;
+
     disp_wait_for_pending_transactions();
+#if ILI9341_3WIRE
+    ili9341_send_9bit(&cmd, 1, false);
+#else
     gpio_set_level(ILI9341_DC, 0);	 /*Command mode*/    
     disp_spi_send_data(&cmd, 1);
+#endif
 }
 
 static void ili9341_send_data(void * data, uint16_t length)
 {
     disp_wait_for_pending_transactions();
+#if ILI9341_3WIRE
+    ili9341_send_9bit(data, length, true);
+#else
     gpio_set_level(ILI9341_DC, 1);	 /*Data mode*/
     disp_spi_send_data(data, length);
+#endif
 }
 
-static void ili9341_send_color(void * data, uint16_t length)
+#if !ILI9341_3WIRE
+static void ili9341_send_color(void * data, uint32_t length)
 {
-    disp_wait_for_pending_transactions();
-    gpio_set_level(ILI9341_DC, 1);   /*Data mode*/
-    disp_spi_send_colors(data, length);
+    /*Queued behind the window setup, the SPI ISR raises DC for it*/
+    disp_spi_transaction(data, length,
+        DISP_SPI_SEND_QUEUED | DISP_SPI_SIGNAL_FLUSH | DISP_SPI_DC_DATA,
+        NULL, 0, 0);
 }
+#endif
+
+/*Queue CASET/PASET/RAMWR for the area. Consecutive stripes share the column window, so
+ *CASET and PASET only go out when their parameters changed. RAMWR is always sent, it
+ *restarts the write at the window origin. Nothing here waits for the bus.*/
+static void ili9341_set_window(const lv_area_t * area)
+{
+    uint8_t col[4] = {
+        (area->x1 >> 8) & 0xFF, area->x1 & 0xFF,
+        (area->x2 >> 8) & 0xFF, area->x2 & 0xFF
+    };
+    uint8_t page[4] = {
+        (area->y1 >> 8) & 0xFF, area->y1 & 0xFF,
+        (area->y2 >> 8) & 0xFF, area->y2 & 0xFF
+    };
+
+#if ILI9341_3WIRE
+    disp_spi_9bit_enc_init(&ili9341_burst, (uint8_t *)ili9341_9bit_buf);
+#endif
+
+	/*Column addresses*/
+    if (!s_tWindow.valid || memcmp(col, s_tWindow.col, sizeof(col)) != 0)
+    {
+        ili9341_queue_cmd(0x2A, col, sizeof(col));
+        memcpy(s_tWindow.col, col, sizeof(col));
+    }
+
+	/*Page addresses*/
+    if (!s_tWindow.valid || memcmp(page, s_tWindow.page, sizeof(page)) != 0)
+    {
+        ili9341_queue_cmd(0x2B, page, sizeof(page));
+        memcpy(s_tWindow.page, page, sizeof(page));
+    }
+
+	/*Memory write*/
+    ili9341_queue_cmd(0x2C, NULL, 0);
+
+#if ILI9341_3WIRE
+    /*At most 11 bytes, the whole window setup is a single transfer*/
+    lvgl_spi_transmit_bits((const uint8_t *)ili9341_9bit_buf, disp_spi_9bit_enc_finish(&ili9341_burst));
+#endif
+
+    s_tWindow.valid = true;
+}
+
+/*Command byte with DC low, then its parameters with DC high. Both are copied into the
+ *transaction pool, so they may live on the stack.*/
+static void ili9341_queue_cmd(uint8_t cmd, const uint8_t * data, size_t length)
+{
+#if ILI9341_3WIRE
+    /*D/C is in-band, append to the window burst sent by ili9341_set_window()*/
+    disp_spi_9bit_enc_put(&ili9341_burst, &cmd, 1, false);
+    disp_spi_9bit_enc_put(&ili9341_burst, data, length, true);
+#else
+    disp_spi_transaction(&cmd, 1, DISP_SPI_SEND_QUEUED | DISP_SPI_DC_CMD, NULL, 0, 0);
+    if (length)
+    {
+        disp_spi_transaction(data, length, DISP_SPI_SEND_QUEUED | DISP_SPI_DC_DATA, NULL, 0, 0);
+    }
+#endif
+}
+
+#if ILI9341_3WIRE
+/*Pack and send in loads of ILI9341_9BIT_CHUNK bytes. The next load is packed while the
+ *previous one shifts out, spi_trans() only waits for the shifter when it copies it in.*/
+static void ili9341_send_9bit(const uint8_t * data, uint32_t length, bool dc)
+{
+    disp_spi_9bit_enc_t enc;
+
+    while (length)
+    {
+        uint32_t n = length > ILI9341_9BIT_CHUNK ? ILI9341_9BIT_CHUNK : length;
+
+        disp_spi_9bit_enc_init(&enc, (uint8_t *)ili9341_9bit_buf);
+        disp_spi_9bit_enc_put(&enc, data, n, dc);
+        lvgl_spi_transmit_bits((const uint8_t *)ili9341_9bit_buf, disp_spi_9bit_enc_finish(&enc));
+
+        data += n;
+        length -= n;
+    }
+}
+#endif
 
 static void ili9341_set_orientation(uint8_t orientation)
 {
-    LOGI("Enter >>");
+    LVGL_LOGI("Enter >>");
     // ESP_ASSERT(orientation < 4);
 
-    const char *orientation_str[] = {
+    static const char *orientation_str[] = {
         "PORTRAIT", "PORTRAIT_INVERTED", "LANDSCAPE", "LANDSCAPE_INVERTED"
     };
 
-    LOGI("Display orientation: %s", orientation_str[orientation]);
+    LVGL_LOGI("Display orientation: %s", orientation_str[orientation]);
 
 #if defined CONFIG_LV_PREDEFINED_DISPLAY_M5STACK
     uint8_t data[] = {0x68, 0x68, 0x08, 0x08};
@@ -265,10 +424,10 @@ static void ili9341_set_orientation(uint8_t orientation)
     uint8_t data[] = {0x48, 0x88, 0x28, 0xE8};
 #endif
 
-    LOGI("0x36 command value: 0x%02X", data[orientation]);
+    LVGL_LOGI("0x36 command value: 0x%02X", data[orientation]);
 
     ili9341_send_cmd(0x36);
     ili9341_send_data((void *) &data[orientation], 1);
     
-    LOGI("End <<");
+    LVGL_LOGI("End <<");
 }
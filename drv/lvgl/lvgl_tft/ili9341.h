@@ -27,6 +27,10 @@ extern "C" {
 #define ILI9341_USE_RST   CONFIG_LV_DISP_USE_RST
 #define ILI9341_RST       CONFIG_LV_DISP_PIN_RST
 #define ILI9341_INVERT_COLORS CONFIG_LV_INVERT_COLORS
+/* 3-line 9-bit interface. The CPU packs every FIFO load, so this flush is synchronous:
+ * ili9341_flush() returns with the colors on the wire and lv_disp_flush_ready() called.
+ * Unlike the 4-wire stream, LVGL cannot render the next area while they go out */
+#define ILI9341_3WIRE     CONFIG_LV_DISP_SPI_3WIRE
 
 /**********************
  *      TYPEDEFS
@@ -36,6 +40,9 @@ extern "C" {
  * GLOBAL PROTOTYPES
  **********************/
 
+/* Hand the driver to disp_driver_register() */
+void ili9341_register(void);
+
 void ili9341_init(void);
 void ili9341_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map);
 void ili9341_sleep_in(void);
@@ -0,0 +1,197 @@
+/**
+ * @file ili9341_decode.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "ili9341_decode.h"
+#include "disp_spi_9bit.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define ILI9341_CASET   0x2A
+#define ILI9341_PASET   0x2B
+#define ILI9341_RAMWR   0x2C
+#define ILI9341_RAMWRC  0x3C
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void ili9341_decode_cmd(ili9341_decode_t *dec, uint8_t cmd);
+static void ili9341_decode_param(ili9341_decode_t *dec, uint8_t data);
+static void ili9341_decode_pixel(ili9341_decode_t *dec, uint16_t color);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void ili9341_decode_init(ili9341_decode_t *dec, uint16_t *fb, uint16_t width, uint16_t height)
+{
+    memset(dec, 0, sizeof(*dec));
+    dec->fb = fb;
+    dec->width = width;
+    dec->height = height;
+
+    /* Reset values of the controller: the whole 240x320 memory */
+    dec->x2 = 239;
+    dec->y2 = 319;
+}
+
+void ili9341_decode_feed(ili9341_decode_t *dec, const uint8_t *data, size_t len, bool dc)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (dc)
+        {
+            ili9341_decode_param(dec, data[i]);
+        }
+        else
+        {
+            ili9341_decode_cmd(dec, data[i]);
+        }
+    }
+}
+
+void ili9341_decode_feed_9bit(ili9341_decode_t *dec, const uint8_t *data, size_t bits)
+{
+    uint8_t bytes[DISP_SPI_9BIT_GROUP];
+    bool dc[DISP_SPI_9BIT_GROUP];
+
+    /* A group of 8 units is 9 whole input bytes, so every group starts on a byte */
+    while (bits)
+    {
+        size_t group_bits = bits > DISP_SPI_9BIT_GROUP * 9 ? DISP_SPI_9BIT_GROUP * 9 : bits;
+        size_t n = disp_spi_9bit_decode(data, group_bits, bytes, dc);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            ili9341_decode_feed(dec, &bytes[i], 1, dc[i]);
+        }
+
+        data += 9;
+        bits -= group_bits;
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void ili9341_decode_cmd(ili9341_decode_t *dec, uint8_t cmd)
+{
+    dec->cmds++;
+    dec->cmd = cmd;
+    dec->nparam = 0;
+    dec->pix_half = false;
+
+    switch (cmd)
+    {
+        case ILI9341_CASET:
+            dec->caset++;
+            break;
+        case ILI9341_PASET:
+            dec->paset++;
+            break;
+        case ILI9341_RAMWR:
+            /* A memory write starts over at the window origin, a continue does not */
+            dec->ramwr++;
+            dec->x = dec->x1;
+            dec->y = dec->y1;
+            break;
+        default:
+            break;
+    }
+}
+
+static void ili9341_decode_param(ili9341_decode_t *dec, uint8_t data)
+{
+    switch (dec->cmd)
+    {
+        case ILI9341_CASET:
+        case ILI9341_PASET:
+            if (dec->nparam < 4)
+            {
+                dec->param[dec->nparam++] = data;
+            }
+            if (dec->nparam == 4)
+            {
+                uint16_t start = ((uint16_t)dec->param[0] << 8) | dec->param[1];
+                uint16_t end = ((uint16_t)dec->param[2] << 8) | dec->param[3];
+                if (dec->cmd == ILI9341_CASET)
+                {
+                    dec->x1 = start;
+                    dec->x2 = end;
+                }
+                else
+                {
+                    dec->y1 = start;
+                    dec->y2 = end;
+                }
+                dec->nparam++;
+            }
+            break;
+
+        case ILI9341_RAMWR:
+        case ILI9341_RAMWRC:
+            /* 16 bpp, the high byte goes out first */
+            if (!dec->pix_half)
+            {
+                dec->pix_hi = data;
+                dec->pix_half = true;
+            }
+            else
+            {
+                dec->pix_half = false;
+                ili9341_decode_pixel(dec, ((uint16_t)dec->pix_hi << 8) | data);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void ili9341_decode_pixel(ili9341_decode_t *dec, uint16_t color)
+{
+    dec->pixels++;
+
+    if (dec->x < dec->width && dec->y < dec->height)
+    {
+        if (dec->fb)
+        {
+            dec->fb[(uint32_t)dec->y * dec->width + dec->x] = color;
+        }
+    }
+    else
+    {
+        dec->clipped++;
+    }
+
+    /* Left to right inside the window, then the next page, wrapping like the controller */
+    if (dec->x >= dec->x2)
+    {
+        dec->x = dec->x1;
+        dec->y = dec->y >= dec->y2 ? dec->y1 : dec->y + 1;
+    }
+    else
+    {
+        dec->x++;
+    }
+}
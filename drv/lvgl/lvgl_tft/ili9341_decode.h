@@ -0,0 +1,70 @@
+/**
+ * @file ili9341_decode.h
+ *
+ * Replays a captured ILI9341 command stream (see lvgl_spi_set_capture()) into a
+ * virtual framebuffer. Plain C without SDK includes, so it builds next to the
+ * capture wherever it is analysed.
+ */
+
+#ifndef ILI9341_DECODE_H
+#define ILI9341_DECODE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    uint16_t *fb;           /* width * height RGB565 words in panel memory order, may be NULL */
+    uint16_t width;
+    uint16_t height;
+
+    uint16_t x1, x2, y1, y2;/* current CASET/PASET window */
+    uint16_t x, y;          /* next pixel of the memory write */
+    uint8_t cmd;            /* last command byte */
+    uint8_t param[4];
+    uint8_t nparam;
+    uint8_t pix_hi;         /* first byte of a pixel */
+    bool pix_half;
+
+    uint32_t cmds;          /* command bytes seen */
+    uint32_t caset;
+    uint32_t paset;
+    uint32_t ramwr;
+    uint32_t pixels;        /* pixels written */
+    uint32_t clipped;       /* pixels outside the framebuffer */
+} ili9341_decode_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+void ili9341_decode_init(ili9341_decode_t *dec, uint16_t *fb, uint16_t width, uint16_t height);
+
+/* Feed bytes captured on the 4-wire bus, dc is the level of the DC line while they went out */
+void ili9341_decode_feed(ili9341_decode_t *dec, const uint8_t *data, size_t len, bool dc);
+
+/* Feed a 3-line 9-bit stream, it has to start on a unit boundary */
+void ili9341_decode_feed_9bit(ili9341_decode_t *dec, const uint8_t *data, size_t bits);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*ILI9341_DECODE_H*/
@@ -5,20 +5,52 @@
 /*********************
  *      INCLUDES
  *********************/
+#include <assert.h>
+
 #include "ili9488.h"
 #include "disp_spi.h"
+#include "../lvgl_log.h"
 #include "rom/gpio.h"
 #include "esp_log.h"
-#include "esp_heap_caps.h"
+#include "esp_attr.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 
 /*********************
  *      DEFINES
  *********************/
  #define TAG "ILI9488"
 
+/*Pixels expanded per chunk, 3 bytes each on the wire*/
+#define ILI9488_CHUNK_PX    (128)
+/*Chunk buffers of the ring, one is converted while the ones before it are sent*/
+#define ILI9488_CHUNKS      (3)
+
+#if ILI9488_CHUNK_PX % 4
+#error "ILI9488_CHUNK_PX must be a multiple of 4, the chunks are filled a word at a time"
+#endif
+
+/*Resolution in CONFIG_LV_DISPLAY_ORIENTATION, 2 and 3 are landscape*/
+#if CONFIG_LV_DISPLAY_ORIENTATION < 2
+#define ILI9488_HOR_RES     (320)
+#define ILI9488_VER_RES     (480)
+#else
+#define ILI9488_HOR_RES     (480)
+#define ILI9488_VER_RES     (320)
+#endif
+
+/*Position of the high and low byte of a RGB565 pixel in a memory word. Only LV_COLOR_16_SWAP is
+ *built and checked by host/test/test_ili9488.c, the ILI9341 next to it needs it*/
+#if LV_COLOR_16_SWAP
+#define ILI9488_HI_SHIFT    (0)
+#define ILI9488_LO_SHIFT    (8)
+#else
+#define ILI9488_HI_SHIFT    (8)
+#define ILI9488_LO_SHIFT    (0)
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -34,22 +66,55 @@ typedef struct {
  *  STATIC PROTOTYPES
  **********************/
 static void ili9488_set_orientation(uint8_t orientation);
+static void ili9488_sleep(bool enter);
 
 static void ili9488_send_cmd(uint8_t cmd);
 static void ili9488_send_data(void * data, uint16_t length);
-static void ili9488_send_color(void * data, uint16_t length);
+static void ili9488_queue_cmd(uint8_t cmd, const uint8_t * data, size_t length);
+static void ili9488_lut_init(void);
+static void ili9488_rgb565_to_rgb666(uint8_t * out, const uint8_t * in, uint32_t px);
+static bool ili9488_chunk_done(void * arg);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+/*RGB666 bytes of a RGB565 pixel, by its high byte R | G<<8 and by its low byte G | B<<8*/
+static uint16_t ili9488_lut_hi[256];
+static uint16_t ili9488_lut_lo[256];
+
+static uint32_t ili9488_chunk_buf[ILI9488_CHUNKS][ILI9488_CHUNK_PX * 3 / 4];
+static uint32_t ili9488_chunk_next = 0;
+static SemaphoreHandle_t ili9488_chunk_free = NULL;     /*counts the chunk buffers not in flight*/
+
+/*15 lines of the 480 px side keep each draw buffer within the 240 x 30 of the ILI9341 in either orientation*/
+static const disp_driver_t ili9488_driver = {
+    .name = "ili9488",
+    .hor_res = ILI9488_HOR_RES,
+    .ver_res = ILI9488_VER_RES,
+    .buf_lines = 15,
+    .caps = DISP_DRIVER_FMT_RGB666 | DISP_DRIVER_CAP_FLUSH_READY,
+    .max_spi_hz = 40 * 1000 * 1000,
+    .init = ili9488_init,
+    .flush = ili9488_flush,
+    .sleep = ili9488_sleep,
+    .set_orientation = ili9488_set_orientation,
+};
 
 /**********************
  *      MACROS
  **********************/
+/*Pixel of a memory word at bit s as R | G<<8 | B<<16, i.e. its 3 bytes in wire order*/
+#define ILI9488_PX(w, s)    (ili9488_lut_hi[((w) >> ((s) + ILI9488_HI_SHIFT)) & 0xFF] | \
+                             ((uint32_t)ili9488_lut_lo[((w) >> ((s) + ILI9488_LO_SHIFT)) & 0xFF] << 8))
 
 /**********************
  *   GLOBAL FUNCTIONS
  **********************/
+void ili9488_register(void)
+{
+    disp_driver_register(&ili9488_driver);
+}
+
 // From github.com/jeremyjh/ESP32_TFT_library
 // From github.com/mvturnho/ILI9488-lvgl-ESP32-WROVER-B
 void ili9488_init(void)
@@ -92,6 +157,10 @@ void ili9488_init(void)
 
 	ESP_LOGI(TAG, "ILI9488 initialization.");
 
+    ili9488_lut_init();
+    ili9488_chunk_free = xSemaphoreCreateCounting(ILI9488_CHUNKS, ILI9488_CHUNKS);
+    assert(ili9488_chunk_free != NULL);
+
 	// Exit sleep
 	ili9488_send_cmd(0x01);	/* Software reset */
 	vTaskDelay(100 / portTICK_RATE_MS);
@@ -110,30 +179,10 @@ void ili9488_init(void)
     ili9488_set_orientation(CONFIG_LV_DISPLAY_ORIENTATION);
 }
 
-// Flush function based on mvturnho repo
 void ili9488_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map)
 {
     uint32_t size = lv_area_get_width(area) * lv_area_get_height(area);
-
-    lv_color16_t *buffer_16bit = (lv_color16_t *) color_map;
-    uint8_t *mybuf;
-    do {
-        mybuf = (uint8_t *) heap_caps_malloc(3 * size * sizeof(uint8_t), MALLOC_CAP_DMA);
-        if (mybuf == NULL)  ESP_LOGW(TAG, "Could not allocate enough DMA memory!");
-    } while (mybuf == NULL);
-
-    uint32_t LD = 0;
-    uint32_t j = 0;
-
-    for (uint32_t i = 0; i < size; i++) {
-        LD = buffer_16bit[i].full;
-        mybuf[j] = (uint8_t) (((LD & 0xF800) >> 8) | ((LD & 0x8000) >> 13));
-        j++;
-        mybuf[j] = (uint8_t) ((LD & 0x07E0) >> 3);
-        j++;
-        mybuf[j] = (uint8_t) (((LD & 0x001F) << 3) | ((LD & 0x0010) >> 2));
-        j++;
-    }
+    const uint8_t *src = (const uint8_t *) color_map;
 
 	/* Column addresses  */
 	uint8_t xb[] = {
@@ -151,19 +200,27 @@ void ili9488_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * col
 	    (uint8_t) (area->y2) & 0xFF,
 	};
 
-	/*Column addresses*/
-	ili9488_send_cmd(ILI9488_CMD_COLUMN_ADDRESS_SET);
-	ili9488_send_data(xb, 4);
-
-	/*Page addresses*/
-	ili9488_send_cmd(ILI9488_CMD_PAGE_ADDRESS_SET);
-	ili9488_send_data(yb, 4);
-
-	/*Memory write*/
-	ili9488_send_cmd(ILI9488_CMD_MEMORY_WRITE);
-
-	ili9488_send_color((void *) mybuf, size * 3);
-	heap_caps_free(mybuf);
+	/*Column addresses, page addresses, memory write. Queued, nothing waits for the previous flush*/
+	ili9488_queue_cmd(ILI9488_CMD_COLUMN_ADDRESS_SET, xb, sizeof(xb));
+	ili9488_queue_cmd(ILI9488_CMD_PAGE_ADDRESS_SET, yb, sizeof(yb));
+	ili9488_queue_cmd(ILI9488_CMD_MEMORY_WRITE, NULL, 0);
+
+    /*RGB666 is expanded chunk by chunk into the ring while the SPI ISR sends the chunks before it.
+     *The last chunk signals the flush, color_map is not read any more once this returns*/
+    while (size) {
+        uint32_t px = size > ILI9488_CHUNK_PX ? ILI9488_CHUNK_PX : size;
+        uint8_t *chunk = (uint8_t *) ili9488_chunk_buf[ili9488_chunk_next];
+
+        xSemaphoreTake(ili9488_chunk_free, portMAX_DELAY);
+        ili9488_rgb565_to_rgb666(chunk, src, px);
+        src += px * 2;
+        size -= px;
+
+        disp_spi_queue_data(chunk, px * 3,
+            DISP_SPI_SEND_QUEUED | DISP_SPI_DC_DATA | (size ? 0 : DISP_SPI_SIGNAL_FLUSH),
+            ili9488_chunk_done, NULL);
+        ili9488_chunk_next = (ili9488_chunk_next + 1) % ILI9488_CHUNKS;
+    }
 }
 
 /**********************
@@ -185,28 +242,103 @@ static void ili9488_send_data(void * data, uint16_t length)
     disp_spi_send_data(data, length);
 }
 
-static void ili9488_send_color(void * data, uint16_t length)
+/*Command byte with DC low, then its parameters with DC high, both copied into the transaction pool*/
+static void ili9488_queue_cmd(uint8_t cmd, const uint8_t * data, size_t length)
 {
-    disp_wait_for_pending_transactions();
-    gpio_set_level(ILI9488_DC, 1);   /*Data mode*/
-    disp_spi_send_colors(data, length);
+    disp_spi_transaction(&cmd, 1, DISP_SPI_SEND_QUEUED | DISP_SPI_DC_CMD, NULL, 0, 0);
+    if (length)
+    {
+        disp_spi_transaction(data, length, DISP_SPI_SEND_QUEUED | DISP_SPI_DC_DATA, NULL, 0, 0);
+    }
+}
+
+/*Same expansion as the per-pixel math it replaces: 5 and 6 bit channels shifted to the top
+ *of the byte, the MSB of red and blue repeated into bit 2*/
+static void ili9488_lut_init(void)
+{
+    for (uint32_t b = 0; b < 256; b++)
+    {
+        uint32_t r = (b & 0xF8) | ((b & 0x80) >> 5);
+        uint32_t g_hi = (b & 0x07) << 5;
+        uint32_t g_lo = (b & 0xE0) >> 3;
+        uint32_t bl = ((b & 0x1F) << 3) | ((b & 0x10) >> 2);
+
+        ili9488_lut_hi[b] = (uint16_t)(r | (g_hi << 8));
+        ili9488_lut_lo[b] = (uint16_t)(g_lo | (bl << 8));
+    }
+}
+
+/*Four pixels are two words in and three words out. The LVGL buffer and the chunks are word
+ *aligned, an odd source only happens for a caller outside LVGL and takes the byte path*/
+static void IRAM_ATTR ili9488_rgb565_to_rgb666(uint8_t * out, const uint8_t * in, uint32_t px)
+{
+    uint32_t i = 0;
+
+    if (((uintptr_t)in & 0x3) == 0)
+    {
+        const uint32_t *src = (const uint32_t *) in;
+        uint32_t *dst = (uint32_t *) out;
+
+        for (; i + 4 <= px; i += 4)
+        {
+            uint32_t w0 = src[0];
+            uint32_t w1 = src[1];
+            uint32_t p0 = ILI9488_PX(w0, 0);
+            uint32_t p1 = ILI9488_PX(w0, 16);
+            uint32_t p2 = ILI9488_PX(w1, 0);
+            uint32_t p3 = ILI9488_PX(w1, 16);
+
+            dst[0] = p0 | (p1 << 24);
+            dst[1] = (p1 >> 8) | (p2 << 16);
+            dst[2] = (p2 >> 16) | (p3 << 8);
+            src += 2;
+            dst += 3;
+        }
+    }
+
+    for (; i < px; i++)
+    {
+        uint32_t w = in[2 * i] | ((uint32_t)in[2 * i + 1] << 8);
+        uint32_t p = ILI9488_PX(w, 0);
+
+        out[3 * i] = (uint8_t) p;
+        out[3 * i + 1] = (uint8_t) (p >> 8);
+        out[3 * i + 2] = (uint8_t) (p >> 16);
+    }
+}
+
+/*SPI ISR, a chunk is on the wire and its buffer free for the next one*/
+static bool IRAM_ATTR ili9488_chunk_done(void * arg)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    (void) arg;
+
+    xSemaphoreGiveFromISR(ili9488_chunk_free, &xHigherPriorityTaskWoken);
+    return xHigherPriorityTaskWoken == pdTRUE;
+}
+
+/*Sleep in needs 5 ms before the next command, sleep out 120 ms*/
+static void ili9488_sleep(bool enter)
+{
+    ili9488_send_cmd(enter ? ILI9488_CMD_ENTER_SLEEP_MODE : ILI9488_CMD_SLEEP_OUT);
+    vTaskDelay((enter ? 5 : 120) / portTICK_RATE_MS + 1);
 }
 
 static void ili9488_set_orientation(uint8_t orientation)
 {
     // ESP_ASSERT(orientation < 4);
 
-    const char *orientation_str[] = {
+    static const char *orientation_str[] = {
         "PORTRAIT", "PORTRAIT_INVERTED", "LANDSCAPE", "LANDSCAPE_INVERTED"
     };
 
-    ESP_LOGI(TAG, "Display orientation: %s", orientation_str[orientation]);
+    LVGL_LOGI("Display orientation: %s", orientation_str[orientation]);
 
 #if defined (CONFIG_LV_PREDEFINED_DISPLAY_NONE)
     uint8_t data[] = {0x48, 0x88, 0x28, 0xE8};
 #endif
 
-    ESP_LOGI(TAG, "0x36 command value: 0x%02X", data[orientation]);
+    LVGL_LOGI("0x36 command value: 0x%02X", data[orientation]);
 
     ili9488_send_cmd(0x36);
     ili9488_send_data((void *) &data[orientation], 1);
@@ -141,6 +141,9 @@ typedef struct {
  * GLOBAL PROTOTYPES
  **********************/
 
+/* Hand the driver to disp_driver_register() */
+void ili9488_register(void);
+
 void ili9488_init(void);
 void ili9488_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map);
 
@@ -23,6 +23,15 @@ void touch_driver_init(void)
 #endif
 }
 
+void touch_driver_set_wake_cb(void (*cb)(void))
+{
+#if defined (CONFIG_LV_TOUCH_CONTROLLER_XPT2046)
+    xpt2046_set_wake_cb(cb);
+#else
+    (void) cb;
+#endif
+}
+
 #if LVGL_VERSION_MAJOR >= 8
 void touch_driver_read(lv_indev_drv_t *drv, lv_indev_data_t *data)
 #else
@@ -46,6 +46,9 @@ extern "C" {
  **********************/
 void touch_driver_init(void);
 
+/* cb is called from an ISR on a touch, controllers without an IRQ line are only polled */
+void touch_driver_set_wake_cb(void (*cb)(void));
+
 #if LVGL_VERSION_MAJOR >= 8
 void touch_driver_read(lv_indev_drv_t *drv, lv_indev_data_t *data);
 #else
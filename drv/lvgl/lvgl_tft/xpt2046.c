@@ -39,6 +39,9 @@ static void xpt2046_corr(int16_t * x, int16_t * y);
 static void xpt2046_avg(int16_t * x, int16_t * y);
 static int16_t xpt2046_cmd(uint8_t cmd);
 static xpt2046_touch_detect_t xpt2048_is_touch_detected();
+#if XPT2046_TOUCH_IRQ || XPT2046_TOUCH_IRQ_PRESS
+static void xpt2046_irq_isr(void *arg);
+#endif
 
 /**********************
  *  STATIC VARIABLES
@@ -46,6 +49,7 @@ static xpt2046_touch_detect_t xpt2048_is_touch_detected();
 int16_t avg_buf_x[XPT2046_AVG];
 int16_t avg_buf_y[XPT2046_AVG];
 uint8_t avg_last;
+static void (*wake_cb)(void);
 
 /**********************
  *      MACROS
@@ -76,6 +80,23 @@ void xpt2046_init(void)
 #endif
 }
 
+/**
+ * Call cb from the GPIO ISR when the pen goes down, so the GUI task does not
+ * have to wait for the next indev poll. Needs the IRQ line.
+ * @param cb called in interrupt context
+ */
+void xpt2046_set_wake_cb(void (*cb)(void))
+{
+#if XPT2046_TOUCH_IRQ || XPT2046_TOUCH_IRQ_PRESS
+    wake_cb = cb;
+    gpio_set_intr_type(XPT2046_IRQ, GPIO_INTR_NEGEDGE);
+    gpio_install_isr_service(0);
+    gpio_isr_handler_add(XPT2046_IRQ, xpt2046_irq_isr, NULL);
+#else
+    (void) cb;
+#endif
+}
+
 /**
  * Get the current position and state of the touchpad
  * @param data store the read data here
@@ -124,6 +145,14 @@ bool xpt2046_read(lv_indev_drv_t * drv, lv_indev_data_t * data)
 /**********************
  *   STATIC FUNCTIONS
  **********************/
+#if XPT2046_TOUCH_IRQ || XPT2046_TOUCH_IRQ_PRESS
+static void IRAM_ATTR xpt2046_irq_isr(void *arg)
+{
+    (void) arg;
+    if (wake_cb) wake_cb();
+}
+#endif
+
 static xpt2046_touch_detect_t xpt2048_is_touch_detected()
 {
     // check IRQ pin if we IRQ or IRQ and preessure
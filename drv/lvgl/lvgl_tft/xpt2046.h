@@ -50,6 +50,7 @@ extern "C" {
  **********************/
 void xpt2046_init(void);
 bool xpt2046_read(lv_indev_drv_t * drv, lv_indev_data_t * data);
+void xpt2046_set_wake_cb(void (*cb)(void));
 
 /**********************
  *      MACROS
@@ -0,0 +1,75 @@
+/**
+ * @file lvgl_tick.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl_tick.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static volatile bool s_bHeld = false;
+static uint32_t s_uiHeldMs = 0;         /* returned while held */
+static uint32_t s_uiOffsetMs = 0;       /* time spent held, taken off the system time */
+
+/**********************
+ *      MACROS
+ **********************/
+/* Unsigned arithmetic keeps the differences right across the wrap of the tick count */
+#define SYS_MS()    ((uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS))
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+uint32_t lvgl_tick_get(void)
+{
+    if (s_bHeld)
+    {
+        return s_uiHeldMs;
+    }
+    return SYS_MS() - s_uiOffsetMs;
+}
+
+void lvgl_tick_hold(bool bHold)
+{
+    if (bHold && !s_bHeld)
+    {
+        s_uiHeldMs = SYS_MS() - s_uiOffsetMs;
+        s_bHeld = true;
+    }
+    else if (!bHold && s_bHeld)
+    {
+        s_uiOffsetMs = SYS_MS() - s_uiHeldMs;
+        s_bHeld = false;
+    }
+}
+
+void lvgl_tick_inc(uint32_t uiMs)
+{
+    if (s_bHeld)
+    {
+        s_uiHeldMs += uiMs;
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
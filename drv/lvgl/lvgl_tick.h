@@ -0,0 +1,48 @@
+/**
+ * @file lvgl_tick.h
+ * Millisecond time source for LV_TICK_CUSTOM, no timer interrupt needed
+ */
+
+#ifndef LVGL_TICK_H
+#define LVGL_TICK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdbool.h>
+#include <stdint.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* Milliseconds from the FreeRTOS tick count, wraps at 2^32 like lv_tick_get() expects */
+uint32_t lvgl_tick_get(void);
+
+/* Freeze the time, it only moves with lvgl_tick_inc() until released.
+   After the release it continues from the frozen value, never jumping back */
+void lvgl_tick_hold(bool bHold);
+
+/* Advance the frozen time, ignored while not held */
+void lvgl_tick_inc(uint32_t uiMs);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LVGL_TICK_H */
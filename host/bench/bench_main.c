@@ -0,0 +1,185 @@
+/**
+ * @file bench_main.c
+ * lv_demo_benchmark without a board: the real LVGL renders, the display path of drv/lvgl
+ * flushes into the mock HSPI, and the LVGL tick is simulated. The report goes to stdout
+ * or into a file.
+ *
+ *   bench_lvgl [-p panel] [-f] [-o report.csv]
+ *
+ * -p   registered panel to flush to, "null" drops the pixels. LVGL_DISP_DEFAULT otherwise
+ * -f   fixed time: the clock only jumps to the next LVGL timer, rendering takes no time.
+ *      The refresh counts, flushes and bytes are then the same on every run. Without it
+ *      the clock also moves by the CPU time LVGL took, so the FPS follow the host's speed
+ * -o   write the results into a file instead of stdout
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lvgl.h"
+#include "lvgl_helpers.h"
+#include "lvgl_tft/disp_driver.h"
+#include "lvgl_tft/disp_spi.h"
+#include "lv_demo_benchmark.h"
+
+#include "mock_spi.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+/* Longest jump of the clock when LVGL has no timer due */
+#define BENCH_IDLE_MAX_MS   (1000)
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static bool s_bFinished = false;
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static uint64_t bench_cpu_us(void)
+{
+    struct timespec tNow;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tNow);
+    return (uint64_t)tNow.tv_sec * 1000000 + tNow.tv_nsec / 1000;
+}
+
+/* LVGL waits for the other draw buffer, the held back SPI interrupts run meanwhile */
+static void bench_flush_wait_cb(lv_disp_drv_t* ptDrv)
+{
+    (void) ptDrv;
+    disp_wait_for_pending_transactions();
+}
+
+static void bench_finished_cb(void)
+{
+    s_bFinished = true;
+}
+
+static void bench_usage(const char* pcName)
+{
+    fprintf(stderr, "usage: %s [-p panel] [-f] [-o file]\n", pcName);
+}
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+int main(int argc, char* argv[])
+{
+    const char* pcPanel = NULL;
+    const char* pcOut = NULL;
+    bool bFixed = false;
+    int iOpt;
+
+    while ((iOpt = getopt(argc, argv, "p:fo:")) != -1)
+    {
+        switch (iOpt)
+        {
+        case 'p':
+            pcPanel = optarg;
+            break;
+        case 'f':
+            bFixed = true;
+            break;
+        case 'o':
+            pcOut = optarg;
+            break;
+        default:
+            bench_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    /* Everything the benchmark prints is the report */
+    if (pcOut && freopen(pcOut, "w", stdout) == NULL)
+    {
+        perror(pcOut);
+        return 1;
+    }
+
+    mock_spi_reset(CONFIG_LV_DISP_PIN_DC);
+    if (pcPanel && !disp_driver_select(pcPanel))
+    {
+        return 1;
+    }
+
+    lv_init();
+    lvgl_driver_init();
+
+    const disp_driver_t* ptPanel = disp_driver_get();
+    uint32_t uiBufPx = disp_driver_buf_size();
+    lv_color_t* ptBuf1 = (lv_color_t*)malloc(uiBufPx * sizeof(lv_color_t));
+    lv_color_t* ptBuf2 = NULL;
+    if ((ptPanel->caps & DISP_DRIVER_FMT_MONO) == 0)
+    {
+        ptBuf2 = (lv_color_t*)malloc(uiBufPx * sizeof(lv_color_t));
+    }
+    if (ptBuf1 == NULL || ((ptPanel->caps & DISP_DRIVER_FMT_MONO) == 0 && ptBuf2 == NULL))
+    {
+        fprintf(stderr, "no memory for the draw buffers\n");
+        return 1;
+    }
+
+    static lv_disp_draw_buf_t s_tDrawBuf;
+    static lv_disp_drv_t s_tDispDrv;
+    lv_disp_draw_buf_init(&s_tDrawBuf, ptBuf1, ptBuf2, uiBufPx);
+    lv_disp_drv_init(&s_tDispDrv);
+    s_tDispDrv.hor_res = ptPanel->hor_res;
+    s_tDispDrv.ver_res = ptPanel->ver_res;
+    s_tDispDrv.flush_cb = disp_driver_flush;
+    s_tDispDrv.wait_cb = bench_flush_wait_cb;
+    if (ptPanel->rounder)
+    {
+        s_tDispDrv.rounder_cb = disp_driver_rounder;
+    }
+    if (ptPanel->set_px)
+    {
+        s_tDispDrv.set_px_cb = disp_driver_set_px;
+    }
+    s_tDispDrv.draw_buf = &s_tDrawBuf;
+    lv_disp_drv_register(&s_tDispDrv);
+
+    lv_demo_benchmark_set_version("host");
+    lv_demo_benchmark_set_target(ptPanel->name);
+    lv_demo_benchmark_set_finished_cb(bench_finished_cb);
+    lv_demo_benchmark();
+
+    /* The clock only moves between two lv_timer_handler() calls, LVGL sees every
+     * refresh take the CPU time it took here, or none with -f */
+    uint64_t ullBusyUs = 0;
+    while (!s_bFinished)
+    {
+        uint64_t ullStart = bench_cpu_us();
+        uint32_t uiIdle = lv_timer_handler();
+        uint32_t uiMs = 0;
+
+        if (!bFixed)
+        {
+            ullBusyUs += bench_cpu_us() - ullStart;
+            uiMs = (uint32_t)(ullBusyUs / 1000);
+            ullBusyUs %= 1000;
+        }
+        /* Nothing to do until the next timer, jump there instead of waiting */
+        if (uiMs == 0)
+        {
+            uiMs = LV_CLAMP(1, uiIdle, BENCH_IDLE_MAX_MS);
+        }
+        lv_tick_inc(uiMs);
+    }
+
+    disp_wait_for_pending_transactions();
+    fprintf(stderr, "%s: %u SPI transfers\n", ptPanel->name, mock_spi_get_transfers());
+    fflush(stdout);
+
+    return 0;
+}
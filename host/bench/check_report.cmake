@@ -0,0 +1,54 @@
+# Runs bench_lvgl with the fixed clock and checks the CSV report of lv_demo_benchmark:
+# the header, then one row per scene and opa with as many fields, a refresh count and FPS.
+#
+#   cmake -DBENCH=path/to/bench_lvgl -DREPORT=report.csv -P check_report.cmake
+#
+# Without BENCH an existing REPORT is checked only.
+if(BENCH)
+    execute_process(COMMAND ${BENCH} -f -o ${REPORT} RESULT_VARIABLE RES)
+    if(NOT RES EQUAL 0)
+        message(FATAL_ERROR "${BENCH} failed: ${RES}")
+    endif()
+endif()
+
+file(STRINGS ${REPORT} LINES)
+set(FIELDS 0)
+set(ROWS 0)
+foreach(LINE IN LISTS LINES)
+    if(FIELDS EQUAL 0)
+        if(LINE MATCHES "^scene,opa,refr_cnt,")
+            string(REPLACE "," ";" HEADER "${LINE}")
+            list(LENGTH HEADER FIELDS)
+            list(FIND HEADER "refr_cnt" REFR_IDX)
+            list(FIND HEADER "fps" FPS_IDX)
+        endif()
+        continue()
+    endif()
+
+    # The table ends with the first line that is not a row of it
+    string(REPLACE "," ";" ROW "${LINE}")
+    list(LENGTH ROW LEN)
+    if(NOT LEN EQUAL FIELDS)
+        break()
+    endif()
+    list(GET ROW 0 SCENE)
+    list(GET ROW ${REFR_IDX} REFR)
+    list(GET ROW ${FPS_IDX} FPS)
+    if(NOT REFR MATCHES "^[0-9]+$" OR NOT FPS MATCHES "^[0-9]+$")
+        message(FATAL_ERROR "${REPORT}: bad row: ${LINE}")
+    endif()
+    if(REFR EQUAL 0)
+        message(FATAL_ERROR "${REPORT}: ${SCENE} was never refreshed")
+    endif()
+    math(EXPR ROWS "${ROWS} + 1")
+endforeach()
+
+if(FIELDS EQUAL 0)
+    message(FATAL_ERROR "${REPORT}: no CSV header, build with LV_DEMO_BENCHMARK_REPORT 1")
+endif()
+# Every scene runs normal and with opa
+math(EXPR ODD "${ROWS} % 2")
+if(ROWS LESS 2 OR ODD)
+    message(FATAL_ERROR "${REPORT}: ${ROWS} rows")
+endif()
+message(STATUS "${REPORT}: ${ROWS} rows")
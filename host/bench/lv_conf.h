@@ -0,0 +1,40 @@
+/**
+ * @file lv_conf.h
+ * The lv_conf.h of the firmware for the host benchmark runner, with the few settings
+ * a PC build can not take as they are
+ */
+
+#ifndef LV_CONF_HOST_H
+#define LV_CONF_HOST_H
+
+#include "../../app/lv_examples/lv_conf.h"
+
+/* The runner owns the time and calls lv_tick_inc(), there is no FreeRTOS tick */
+#undef LV_TICK_CUSTOM
+#define LV_TICK_CUSTOM 0
+
+/* The CSV report, bench/check_report.cmake parses it */
+#undef LV_DEMO_BENCHMARK_REPORT
+#define LV_DEMO_BENCHMARK_REPORT 1
+
+/* Pointers take twice the room of the target's */
+#undef LV_MEM_SIZE
+#define LV_MEM_SIZE (128U * 1024U)
+
+/* Trace logs would be formatted for nothing, no print callback is registered */
+#undef LV_LOG_LEVEL
+#define LV_LOG_LEVEL LV_LOG_LEVEL_WARN
+
+/* Every run verifies the scenes first and writes the goldens of this LVGL into the
+ * working directory, see lv_demo_benchmark_golden.h */
+#undef LV_DEMO_BENCHMARK_VERIFY
+#define LV_DEMO_BENCHMARK_VERIFY 1
+#define LV_DEMO_BENCHMARK_GOLDEN_PATH "lv_demo_benchmark_golden.h"
+
+/* Runs are compared with the ones before in the working directory */
+#ifdef LV_DEMO_BENCHMARK_STORE_PATH
+#undef LV_DEMO_BENCHMARK_STORE_PATH
+#define LV_DEMO_BENCHMARK_STORE_PATH "benchmark.bin"
+#endif
+
+#endif /* LV_CONF_HOST_H */
@@ -0,0 +1,45 @@
+/**
+ * @file mock_lvgl.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <assert.h>
+
+#include "mock_lvgl.h"
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_disp_drv_t s_tDispDrv;
+static lv_disp_t s_tDisp = {
+    .driver = &s_tDispDrv,
+};
+static uint32_t s_uiFlushReady = 0;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_disp_flush_ready(lv_disp_drv_t * disp_drv)
+{
+    assert(disp_drv == &s_tDispDrv);
+    s_uiFlushReady++;
+}
+
+lv_disp_t * _lv_refr_get_disp_refreshing(void)
+{
+    return &s_tDisp;
+}
+
+lv_disp_drv_t * mock_lvgl_get_disp_drv(void)
+{
+    return &s_tDispDrv;
+}
+
+uint32_t mock_lvgl_get_flush_ready(void)
+{
+    return s_uiFlushReady;
+}
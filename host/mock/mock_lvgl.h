@@ -0,0 +1,33 @@
+/**
+ * @file mock_lvgl.h
+ * lv_disp_flush_ready() and the refreshing display for the drivers built against the lvgl.h stub
+ */
+
+#ifndef MOCK_LVGL_H
+#define MOCK_LVGL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+
+#include "lvgl.h"
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* The driver _lv_refr_get_disp_refreshing() reports, hand it to the flush callbacks */
+lv_disp_drv_t * mock_lvgl_get_disp_drv(void);
+
+/* lv_disp_flush_ready() calls so far */
+uint32_t mock_lvgl_get_flush_ready(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* MOCK_LVGL_H */
@@ -0,0 +1,240 @@
+/**
+ * @file mock_rtos.c
+ * Queues, semaphores and the clock of FreeRTOS for one task. Where a task would block,
+ * the held back SPI interrupts are run until the call can go on. If none is left it
+ * would block forever, which is reported and aborts the test.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/soc.h"
+#include "lvgl_log.h"
+
+#include "mock_spi.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+/* Mock CPU cycles per call of soc_get_ccount(), enough to keep the counters moving */
+#define MOCK_CCOUNT_STEP        (16)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+struct mock_queue
+{
+    uint8_t* pucItems;
+    UBaseType_t uxLength;
+    UBaseType_t uxItemSize;
+    UBaseType_t uxHead;
+    UBaseType_t uxCount;
+};
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void mock_rtos_block(const char* pcWhat);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static TickType_t s_tTicks = 0;
+static uint32_t s_uiCcount = 0;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+QueueHandle_t xQueueCreate(UBaseType_t uxLength, UBaseType_t uxItemSize)
+{
+    QueueHandle_t xQueue = calloc(1, sizeof(*xQueue));
+
+    assert(xQueue != NULL && uxLength > 0);
+    xQueue->uxLength = uxLength;
+    xQueue->uxItemSize = uxItemSize;
+    if (uxItemSize)
+    {
+        xQueue->pucItems = calloc(uxLength, uxItemSize);
+        assert(xQueue->pucItems != NULL);
+    }
+    return xQueue;
+}
+
+void vQueueDelete(QueueHandle_t xQueue)
+{
+    free(xQueue->pucItems);
+    free(xQueue);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t xQueue, const void* pvItem, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    if (xQueue->uxCount == xQueue->uxLength)
+    {
+        return pdFALSE;
+    }
+
+    if (xQueue->uxItemSize)
+    {
+        UBaseType_t uxTail = (xQueue->uxHead + xQueue->uxCount) % xQueue->uxLength;
+        memcpy(xQueue->pucItems + uxTail * xQueue->uxItemSize, pvItem, xQueue->uxItemSize);
+    }
+    xQueue->uxCount++;
+
+    /* The one task may be waiting for it, that is the case the ISRs have to yield for */
+    if (pxHigherPriorityTaskWoken)
+    {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t xQueue, void* pvBuffer, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    (void) pxHigherPriorityTaskWoken;
+
+    if (xQueue->uxCount == 0)
+    {
+        return pdFALSE;
+    }
+
+    if (xQueue->uxItemSize && pvBuffer)
+    {
+        memcpy(pvBuffer, xQueue->pucItems + xQueue->uxHead * xQueue->uxItemSize, xQueue->uxItemSize);
+    }
+    xQueue->uxHead = (xQueue->uxHead + 1) % xQueue->uxLength;
+    xQueue->uxCount--;
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void* pvItem, TickType_t xTicksToWait)
+{
+    while (xQueueSendFromISR(xQueue, pvItem, NULL) != pdTRUE)
+    {
+        if (xTicksToWait == 0)
+        {
+            return pdFALSE;
+        }
+        mock_rtos_block("xQueueSend");
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait)
+{
+    while (xQueueReceiveFromISR(xQueue, pvBuffer, NULL) != pdTRUE)
+    {
+        if (xTicksToWait == 0)
+        {
+            return pdFALSE;
+        }
+        mock_rtos_block("xQueueReceive");
+    }
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue)
+{
+    return xQueue->uxCount;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount)
+{
+    SemaphoreHandle_t xSem = xQueueCreate(uxMaxCount, 0);
+
+    xSem->uxCount = uxInitialCount;
+    return xSem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    assert(!mock_spi_in_isr());
+    s_tTicks += xTicksToDelay;
+    /* Plenty of time for whatever is on the wire */
+    mock_spi_drain();
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return s_tTicks;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return (int64_t)s_tTicks * 1000 * portTICK_RATE_MS;
+}
+
+uint32_t soc_get_ccount(void)
+{
+    s_uiCcount += MOCK_CCOUNT_STEP;
+    return s_uiCcount;
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    static int s_iVerbose = -1;
+    va_list tArgs;
+
+    if (s_iVerbose < 0)
+    {
+        s_iVerbose = getenv("HOST_LOG_VERBOSE") != NULL;
+    }
+    if (level > ESP_LOG_WARN && !s_iVerbose)
+    {
+        return;
+    }
+
+    fprintf(stderr, "%c (%s) ", "NEWIDV"[level], tag);
+    va_start(tArgs, format);
+    vfprintf(stderr, format, tArgs);
+    va_end(tArgs);
+    fputc('\n', stderr);
+}
+
+/* No drain task here, the record goes out at once. The arguments are left out: on a 64 bit
+ * host a %s argument does not fit the 32 bit words lvgl_log_write() reads */
+void lvgl_log_write(esp_log_level_t eLevel, const char* pcTag, const char* pcFmt, uint32_t uiArgc, ...)
+{
+    esp_log_write(eLevel, pcTag, "%s (%u args)", pcFmt, uiArgc);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/* The task would block: let the pending interrupt happen, nothing else can wake it */
+static void mock_rtos_block(const char* pcWhat)
+{
+    if (mock_spi_in_isr())
+    {
+        fprintf(stderr, "%s would block inside the SPI ISR\n", pcWhat);
+        abort();
+    }
+    if (!mock_spi_isr())
+    {
+        fprintf(stderr, "%s blocks forever, no SPI interrupt is pending\n", pcWhat);
+        abort();
+    }
+}
@@ -0,0 +1,254 @@
+/**
+ * @file mock_spi.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "driver/spi.h"
+#include "rom/gpio.h"
+
+#include "mock_spi.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+/* Address phase and the whole FIFO */
+#define MOCK_SPI_MAX_BYTES      (4 + sizeof(SPI1.data_buf))
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void mock_gpio_apply(void);
+static void mock_spi_shift_out(void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static spi_event_callback_t s_pfnEvent = NULL;
+static mock_spi_wire_cb_t s_pfnWire = NULL;
+static void* s_pWireArg = NULL;
+static uint32_t s_uiDcPin = 0;
+static bool s_bPending = false;
+static bool s_bInIsr = false;
+static uint32_t s_uiTransfers = 0;
+
+/**********************
+ *   GLOBAL VARIABLES
+ **********************/
+spi_dev_t SPI0;
+spi_dev_t SPI1;
+gpio_dev_t GPIO;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void mock_spi_reset(uint32_t uiDcPin)
+{
+    memset((void*)&SPI1, 0, sizeof(SPI1));
+    memset((void*)&GPIO, 0, sizeof(GPIO));
+    s_uiDcPin = uiDcPin;
+    s_bPending = false;
+    s_bInIsr = false;
+    s_uiTransfers = 0;
+}
+
+void mock_spi_set_wire_cb(mock_spi_wire_cb_t pfnCb, void* pArg)
+{
+    s_pfnWire = pfnCb;
+    s_pWireArg = pArg;
+}
+
+bool mock_spi_isr(void)
+{
+    if (!s_bPending)
+    {
+        return false;
+    }
+
+    /* No nesting, the event callback runs with the interrupt masked */
+    assert(!s_bInIsr);
+    s_bPending = false;
+    s_bInIsr = true;
+    if (s_pfnEvent)
+    {
+        s_pfnEvent(SPI_TRANS_DONE_EVENT, NULL);
+    }
+    /* A transfer the callback started on the registers directly */
+    mock_spi_shift_out();
+    s_bInIsr = false;
+
+    return true;
+}
+
+void mock_spi_drain(void)
+{
+    while (mock_spi_isr())
+    {
+    }
+}
+
+bool mock_spi_in_isr(void)
+{
+    return s_bInIsr;
+}
+
+uint32_t mock_spi_get_transfers(void)
+{
+    return s_uiTransfers;
+}
+
+uint32_t mock_gpio_get_out(uint32_t uiPin)
+{
+    mock_gpio_apply();
+    return (GPIO.out >> uiPin) & 1;
+}
+
+/* The SDK driver as lvgl_helpers.c relies on it: the registers are set up for the
+ * phases present, mosi is always copied to W0 and the shifter is started */
+esp_err_t spi_init(spi_host_t host, spi_config_t *config)
+{
+    assert(host == HSPI_HOST);
+    assert(config->mode == SPI_MASTER_MODE);
+    s_pfnEvent = config->event_cb;
+    if (s_pfnEvent)
+    {
+        s_pfnEvent(SPI_INIT_EVENT, NULL);
+    }
+    return ESP_OK;
+}
+
+esp_err_t spi_trans(spi_host_t host, spi_trans_t *trans)
+{
+    assert(host == HSPI_HOST);
+    assert(trans->bits.cmd == 0 && trans->bits.miso == 0);
+    assert(trans->bits.mosi <= sizeof(SPI1.data_buf) * 8);
+
+    /* Waits for the shifter like the SDK does */
+    mock_spi_shift_out();
+
+    SPI1.user.usr_command = 0;
+    SPI1.user.usr_addr = trans->bits.addr ? 1 : 0;
+    if (trans->bits.addr)
+    {
+        SPI1.user1.usr_addr_bitlen = trans->bits.addr - 1;
+        SPI1.addr = *trans->addr;
+    }
+    SPI1.user.usr_mosi = trans->bits.mosi ? 1 : 0;
+    if (trans->bits.mosi)
+    {
+        SPI1.user1.usr_mosi_bitlen = trans->bits.mosi - 1;
+        for (uint32_t i = 0; i < (trans->bits.mosi + 31U) / 32U; i++)
+        {
+            SPI1.data_buf[i] = trans->mosi[i];
+        }
+    }
+    SPI1.cmd.usr = 1;
+    mock_spi_shift_out();
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_config(const gpio_config_t *gpio_cfg)
+{
+    (void) gpio_cfg;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    (void) gpio_num;
+    (void) mode;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    mock_gpio_apply();
+    if (level)
+    {
+        GPIO.out |= 1UL << gpio_num;
+    }
+    else
+    {
+        GPIO.out &= ~(1UL << gpio_num);
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    return (int)mock_gpio_get_out((uint32_t)gpio_num);
+}
+
+void gpio_pad_select_gpio(uint32_t gpio_num)
+{
+    (void) gpio_num;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/* The set/clear registers act on the level at once on the chip */
+static void mock_gpio_apply(void)
+{
+    GPIO.out = (GPIO.out | GPIO.out_w1ts) & ~GPIO.out_w1tc;
+    GPIO.out_w1ts = 0;
+    GPIO.out_w1tc = 0;
+}
+
+/* Record the transfer cmd.usr started and hold back its done interrupt. The FIFO
+ * is read from W8 on when usr_mosi_highpart is set, whatever spi_trans() loaded */
+static void mock_spi_shift_out(void)
+{
+    uint8_t aucWire[MOCK_SPI_MAX_BYTES];
+    uint32_t uiBits = 0;
+
+    if (!SPI1.cmd.usr)
+    {
+        return;
+    }
+
+    memset(aucWire, 0, sizeof(aucWire));
+    if (SPI1.user.usr_addr)
+    {
+        uint32_t uiAddrBits = SPI1.user1.usr_addr_bitlen + 1;
+        assert(uiAddrBits % 8 == 0 && uiAddrBits <= 32);
+        for (uint32_t i = 0; i < uiAddrBits / 8; i++)
+        {
+            aucWire[i] = (uint8_t)(SPI1.addr >> (24 - 8 * i));
+        }
+        uiBits = uiAddrBits;
+    }
+    if (SPI1.user.usr_mosi)
+    {
+        uint32_t uiMosiBits = SPI1.user1.usr_mosi_bitlen + 1;
+        uint32_t uiFirst = SPI1.user.usr_mosi_highpart ? 8 : 0;
+        assert(uiFirst * 32 + uiMosiBits <= sizeof(SPI1.data_buf) * 8);
+        for (uint32_t i = 0; i < (uiMosiBits + 7) / 8; i++)
+        {
+            uint32_t uiWord = SPI1.data_buf[uiFirst + i / 4];
+            aucWire[uiBits / 8 + i] = (uint8_t)(uiWord >> (8 * (i % 4)));
+        }
+        uiBits += uiMosiBits;
+    }
+
+    mock_gpio_apply();
+    s_uiTransfers++;
+    if (s_pfnWire && uiBits)
+    {
+        s_pfnWire(aucWire, uiBits, (GPIO.out >> s_uiDcPin) & 1, s_pWireArg);
+    }
+
+    SPI1.cmd.usr = 0;
+    s_bPending = true;
+}
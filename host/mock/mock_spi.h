@@ -0,0 +1,58 @@
+/**
+ * @file mock_spi.h
+ * HSPI and GPIO of the ESP8266 in memory. Transfers are recorded when they start,
+ * their SPI_TRANS_DONE_EVENT is held back until mock_spi_isr() runs, which the
+ * blocking calls of mock_rtos.c do. So the drivers see their interrupts at the points
+ * where they wait for them, not in between two lines of task code.
+ */
+
+#ifndef MOCK_SPI_H
+#define MOCK_SPI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+/* One transfer as it went out: address phase and data in wire order. uiBits need not be a
+ * multiple of 8, the last byte then holds the rest MSB first. bDc is the DC pin level */
+typedef void (*mock_spi_wire_cb_t)(const uint8_t* pucData, uint32_t uiBits, bool bDc, void* pArg);
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* Clear the registers, the GPIO levels and the held back interrupt. uiDcPin is the GPIO
+ * reported as bDc */
+void mock_spi_reset(uint32_t uiDcPin);
+
+/* Install the wire recorder, NULL removes it */
+void mock_spi_set_wire_cb(mock_spi_wire_cb_t pfnCb, void* pArg);
+
+/* Run the held back interrupt of the last transfer, false if there was none */
+bool mock_spi_isr(void);
+
+/* Run interrupts until the bus stays idle */
+void mock_spi_drain(void);
+
+/* True while mock_spi_isr() runs the event callback */
+bool mock_spi_in_isr(void);
+
+/* Transfers recorded since mock_spi_reset() */
+uint32_t mock_spi_get_transfers(void);
+
+/* Level of an output after the last gpio_set_level() or GPIO.out_w1ts/out_w1tc write */
+uint32_t mock_gpio_get_out(uint32_t uiPin);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* MOCK_SPI_H */
@@ -0,0 +1,13 @@
+/**
+ * @file soc.h
+ */
+
+#ifndef DRIVER_SOC_H
+#define DRIVER_SOC_H
+
+#include <stdint.h>
+
+/* CPU cycles of the mock clock, see mock_rtos.c */
+uint32_t soc_get_ccount(void);
+
+#endif /* DRIVER_SOC_H */
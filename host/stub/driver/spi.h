@@ -0,0 +1,105 @@
+/**
+ * @file spi.h
+ * The master side of the ESP8266 SPI driver as lvgl_helpers.c uses it
+ */
+
+#ifndef DRIVER_SPI_H
+#define DRIVER_SPI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_system.h"
+#include "esp8266/spi_struct.h"
+
+typedef enum {
+    CSPI_HOST = 0,
+    HSPI_HOST
+} spi_host_t;
+
+typedef enum {
+    SPI_2MHz_DIV  = 40,
+    SPI_4MHz_DIV  = 20,
+    SPI_5MHz_DIV  = 16,
+    SPI_8MHz_DIV  = 10,
+    SPI_10MHz_DIV = 8,
+    SPI_16MHz_DIV = 5,
+    SPI_20MHz_DIV = 4,
+    SPI_40MHz_DIV = 2,
+    SPI_80MHz_DIV = 1,
+} spi_clk_div_t;
+
+typedef enum {
+    SPI_INIT_EVENT = 0,
+    SPI_TRANS_START_EVENT,
+    SPI_TRANS_DONE_EVENT,
+    SPI_DEINIT_EVENT
+} spi_event_t;
+
+typedef enum {
+    SPI_MASTER_MODE,
+    SPI_SLAVE_MODE
+} spi_mode_t;
+
+typedef union {
+    struct {
+        uint32_t read_buffer:  1;
+        uint32_t write_buffer: 1;
+        uint32_t read_status:  1;
+        uint32_t write_status: 1;
+        uint32_t trans_done:   1;
+        uint32_t reserved5:    27;
+    };
+    uint32_t val;
+} spi_intr_enable_t;
+
+typedef union {
+    struct {
+        uint32_t cpol:          1;
+        uint32_t cpha:          1;
+        uint32_t bit_tx_order:  1;
+        uint32_t bit_rx_order:  1;
+        uint32_t byte_tx_order: 1;
+        uint32_t byte_rx_order: 1;
+        uint32_t mosi_en:       1;
+        uint32_t miso_en:       1;
+        uint32_t cs_en:         1;
+        uint32_t reserved9:     23;
+    };
+    uint32_t val;
+} spi_interface_t;
+
+typedef void (*spi_event_callback_t)(int event, void *arg);
+
+typedef struct {
+    spi_interface_t interface;
+    spi_intr_enable_t intr_enable;
+    spi_event_callback_t event_cb;
+    spi_mode_t mode;
+    spi_clk_div_t clk_div;
+} spi_config_t;
+
+typedef struct {
+    uint16_t *cmd;
+    uint32_t *addr;
+    uint32_t *mosi;
+    uint32_t *miso;
+    union {
+        struct {
+            uint32_t cmd:  5;
+            uint32_t addr: 7;
+            uint32_t mosi: 10;
+            uint32_t miso: 10;
+        };
+        uint32_t val;
+    } bits;
+} spi_trans_t;
+
+#define SPI_DEFAULT_INTERFACE           0x1C0
+#define SPI_MASTER_DEFAULT_INTR_ENABLE  0x10
+
+esp_err_t spi_init(spi_host_t host, spi_config_t *config);
+esp_err_t spi_trans(spi_host_t host, spi_trans_t *trans);
+
+#endif /* DRIVER_SPI_H */
@@ -0,0 +1,24 @@
+/**
+ * @file gpio_struct.h
+ * out_w1ts and out_w1tc are plain memory here, mock_spi.c applies them to out
+ * before it looks at a level
+ */
+
+#ifndef ESP8266_GPIO_STRUCT_H
+#define ESP8266_GPIO_STRUCT_H
+
+#include <stdint.h>
+
+typedef volatile struct {
+    uint32_t out;
+    uint32_t out_w1ts;
+    uint32_t out_w1tc;
+    uint32_t enable;
+    uint32_t enable_w1ts;
+    uint32_t enable_w1tc;
+    uint32_t in;
+} gpio_dev_t;
+
+extern gpio_dev_t GPIO;
+
+#endif /* ESP8266_GPIO_STRUCT_H */
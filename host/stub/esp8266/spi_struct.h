@@ -0,0 +1,49 @@
+/**
+ * @file spi_struct.h
+ * The HSPI registers the transmit path touches, in plain memory. Setting cmd.usr starts
+ * a transfer, mock_spi.c shifts it out the next time the mock interrupt runs
+ */
+
+#ifndef ESP8266_SPI_STRUCT_H
+#define ESP8266_SPI_STRUCT_H
+
+#include <stdint.h>
+
+typedef volatile struct {
+    union {
+        struct {
+            uint32_t reserved0: 18;
+            uint32_t usr:       1;
+            uint32_t reserved19: 13;
+        };
+        uint32_t val;
+    } cmd;
+    uint32_t addr;
+    union {
+        struct {
+            uint32_t reserved0:         26;
+            uint32_t usr_mosi_highpart: 1;
+            uint32_t usr_miso_highpart: 1;
+            uint32_t usr_mosi:          1;
+            uint32_t usr_miso:          1;
+            uint32_t usr_addr:          1;
+            uint32_t usr_command:       1;
+        };
+        uint32_t val;
+    } user;
+    union {
+        struct {
+            uint32_t usr_dummy_cyclelen: 8;
+            uint32_t usr_miso_bitlen:    9;
+            uint32_t usr_mosi_bitlen:    9;
+            uint32_t usr_addr_bitlen:    6;
+        };
+        uint32_t val;
+    } user1;
+    uint32_t data_buf[16];
+} spi_dev_t;
+
+extern spi_dev_t SPI0;
+extern spi_dev_t SPI1;
+
+#endif /* ESP8266_SPI_STRUCT_H */
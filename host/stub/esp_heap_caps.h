@@ -0,0 +1,17 @@
+/**
+ * @file esp_heap_caps.h
+ * Capability allocations are plain malloc() on the host
+ */
+
+#ifndef ESP_HEAP_CAPS_H
+#define ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_DMA          (1 << 3)
+#define MALLOC_CAP_8BIT         (1 << 2)
+
+#define heap_caps_malloc(size, caps)    malloc(size)
+#define heap_caps_free(ptr)             free(ptr)
+
+#endif /* ESP_HEAP_CAPS_H */
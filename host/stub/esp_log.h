@@ -0,0 +1,34 @@
+/**
+ * @file esp_log.h
+ * Errors and warnings go to stderr, the rest only with HOST_LOG_VERBOSE set in the environment
+ */
+
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <stdint.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOGE(tag, fmt, ...)     esp_log_write(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...)     esp_log_write(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...)     esp_log_write(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...)     esp_log_write(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+
+/* The short forms of the SDK, with the function name in front */
+#define LOGE(fmt, ...)              ESP_LOGE(TAG, "[%s]:" fmt, __func__, ##__VA_ARGS__)
+#define LOGW(fmt, ...)              ESP_LOGW(TAG, "[%s]:" fmt, __func__, ##__VA_ARGS__)
+#define LOGI(fmt, ...)              ESP_LOGI(TAG, "[%s]:" fmt, __func__, ##__VA_ARGS__)
+#define LOGD(fmt, ...)              ESP_LOGD(TAG, "[%s]:" fmt, __func__, ##__VA_ARGS__)
+
+#endif /* ESP_LOG_H */
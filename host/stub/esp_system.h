@@ -0,0 +1,17 @@
+/**
+ * @file esp_system.h
+ */
+
+#ifndef ESP_SYSTEM_H
+#define ESP_SYSTEM_H
+
+#include <stdint.h>
+
+#include "esp_attr.h"
+
+typedef int32_t esp_err_t;
+
+#define ESP_OK      0
+#define ESP_FAIL    -1
+
+#endif /* ESP_SYSTEM_H */
@@ -0,0 +1,13 @@
+/**
+ * @file esp_timer.h
+ */
+
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+
+/* Microseconds of the mock clock, see mock_rtos.c */
+int64_t esp_timer_get_time(void);
+
+#endif /* ESP_TIMER_H */
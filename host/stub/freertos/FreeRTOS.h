@@ -0,0 +1,34 @@
+/**
+ * @file FreeRTOS.h
+ * Single threaded stand-in: blocking calls run the pending SPI interrupts instead of
+ * switching tasks, see mock_rtos.c
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sdkconfig.h"
+
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define portTICK_RATE_MS        ((TickType_t)1000 / CONFIG_FREERTOS_HZ)
+#define portTICK_PERIOD_MS      portTICK_RATE_MS
+
+/* Nothing preempts the host process, the mock ISR only runs from blocking calls */
+#define portENTER_CRITICAL()
+#define portEXIT_CRITICAL()
+#define portYIELD_FROM_ISR()
+#define taskYIELD()
+
+#endif /* FREERTOS_H */
@@ -0,0 +1,23 @@
+/**
+ * @file semphr.h
+ * Semaphores are queues of items without payload, like in FreeRTOS
+ */
+
+#ifndef FREERTOS_SEMPHR_H
+#define FREERTOS_SEMPHR_H
+
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+
+#define xSemaphoreTake(xSemaphore, xBlockTime)  xQueueReceive((xSemaphore), NULL, (xBlockTime))
+#define xSemaphoreGive(xSemaphore)              xQueueSend((xSemaphore), NULL, 0)
+#define xSemaphoreGiveFromISR(xSemaphore, pxHigherPriorityTaskWoken) \
+    xQueueSendFromISR((xSemaphore), NULL, (pxHigherPriorityTaskWoken))
+#define vSemaphoreDelete(xSemaphore)            vQueueDelete(xSemaphore)
+
+#endif /* FREERTOS_SEMPHR_H */
@@ -0,0 +1,16 @@
+/**
+ * @file task.h
+ */
+
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void * TaskHandle_t;
+
+/* Advances the mock clock and runs the SPI interrupts that came due meanwhile */
+void vTaskDelay(TickType_t xTicksToDelay);
+TickType_t xTaskGetTickCount(void);
+
+#endif /* FREERTOS_TASK_H */
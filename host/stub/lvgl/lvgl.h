@@ -0,0 +1,68 @@
+/**
+ * @file lvgl.h
+ * The part of the LVGL v8 API the display drivers use, for building them without LVGL.
+ * Colors as the shipped configuration renders them: RGB565 with LV_COLOR_16_SWAP.
+ * With LVGL_DIR set the real lvgl.h is used instead, see host/CMakeLists.txt
+ */
+
+#ifndef LVGL_H
+#define LVGL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LVGL_VERSION_MAJOR      8
+#define LVGL_VERSION_MINOR      3
+
+#define LV_COLOR_DEPTH          16
+#define LV_COLOR_16_SWAP        1
+
+typedef int16_t lv_coord_t;
+typedef uint8_t lv_opa_t;
+
+typedef struct {
+    lv_coord_t x1;
+    lv_coord_t y1;
+    lv_coord_t x2;
+    lv_coord_t y2;
+} lv_area_t;
+
+typedef union {
+    struct {
+        uint16_t green_h : 3;
+        uint16_t red : 5;
+        uint16_t blue : 5;
+        uint16_t green_l : 3;
+    } ch;
+    uint16_t full;
+} lv_color_t;
+
+typedef lv_color_t lv_color16_t;
+
+typedef struct _lv_disp_drv_t {
+    lv_coord_t hor_res;
+    lv_coord_t ver_res;
+    void * user_data;
+} lv_disp_drv_t;
+
+typedef struct _lv_disp_t {
+    lv_disp_drv_t * driver;
+} lv_disp_t;
+
+/* Counted by mock_lvgl.c */
+void lv_disp_flush_ready(lv_disp_drv_t * disp_drv);
+
+/* The display whose flush is running, see mock_lvgl_get_disp_drv() */
+lv_disp_t * _lv_refr_get_disp_refreshing(void);
+
+static inline lv_coord_t lv_area_get_width(const lv_area_t * area_p)
+{
+    return (lv_coord_t)(area_p->x2 - area_p->x1 + 1);
+}
+
+static inline lv_coord_t lv_area_get_height(const lv_area_t * area_p)
+{
+    return (lv_coord_t)(area_p->y2 - area_p->y1 + 1);
+}
+
+#endif /* LVGL_H */
@@ -0,0 +1,12 @@
+/**
+ * @file gpio.h
+ */
+
+#ifndef ROM_GPIO_H
+#define ROM_GPIO_H
+
+#include "driver/gpio.h"
+
+void gpio_pad_select_gpio(uint32_t gpio_num);
+
+#endif /* ROM_GPIO_H */
@@ -0,0 +1,12 @@
+/**
+ * @file sdkconfig.h
+ * The sdkconfig values the drivers read, as the target build has them
+ */
+
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+#define CONFIG_ESP8266_DEFAULT_CPU_FREQ_MHZ     160
+#define CONFIG_FREERTOS_HZ                      1000
+
+#endif /* SDKCONFIG_H */
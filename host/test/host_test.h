@@ -0,0 +1,38 @@
+/**
+ * @file host_test.h
+ * Checks for the host tests: a failed one is reported and counted, the test goes on
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+static uint32_t s_uiChecksFailed = 0;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond))                                                                \
+        {                                                                           \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);\
+            s_uiChecksFailed++;                                                     \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                              \
+    do {                                                                            \
+        long long llA = (long long)(a);                                             \
+        long long llB = (long long)(b);                                             \
+        if (llA != llB)                                                             \
+        {                                                                           \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n",       \
+                    __FILE__, __LINE__, #a, #b, llA, llB);                          \
+            s_uiChecksFailed++;                                                     \
+        }                                                                           \
+    } while (0)
+
+/* Exit code of main() */
+#define HOST_TEST_RESULT()      (s_uiChecksFailed ? 1 : 0)
+
+#endif /* HOST_TEST_H */
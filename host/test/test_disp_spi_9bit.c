@@ -0,0 +1,242 @@
+/**
+ * @file test_disp_spi_9bit.c
+ * The 3-line 9-bit packing on its own, encode then decode, and the ILI9341 on the
+ * 9-bit interface with flushes around the 56 byte load of LVGL_SPI_MAX_BITS.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "lvgl_helpers.h"
+#include "lvgl_tft/disp_driver.h"
+#include "lvgl_tft/disp_spi.h"
+#include "lvgl_tft/disp_spi_9bit.h"
+#include "lvgl_tft/ili9341_decode.h"
+
+#include "mock_lvgl.h"
+#include "mock_spi.h"
+#include "host_test.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define PANEL_W         (240)
+#define PANEL_H         (320)
+#define LOAD_BYTES      (LVGL_SPI_MAX_BITS / 9)
+#define ROUND_TRIP_MAX  (3 * DISP_SPI_9BIT_GROUP + 5)
+#define XFER_LOG_MAX    (16)
+
+#if !CONFIG_LV_DISP_SPI_3WIRE
+#error "build with CONFIG_LV_DISP_SPI_3WIRE=1"
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+{
+    ili9341_decode_t tDec;
+    uint32_t auiBits[XFER_LOG_MAX];     /* bits of the transfers since the last reset of the log */
+    uint32_t uiXfers;
+} wire_t;
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static uint16_t s_ausFb[PANEL_W * PANEL_H];
+static wire_t s_tWire;
+static uint32_t s_auiColors[256];
+static uint32_t s_uiSeed = 1;
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static uint8_t test_rand(void)
+{
+    s_uiSeed = s_uiSeed * 1103515245 + 12345;
+    return (uint8_t)(s_uiSeed >> 16);
+}
+
+/* 0x2A 0x00 0xEF by hand: 0 00101010, 1 00000000, 1 11101111 and 5 bits of padding */
+static void test_known_stream(void)
+{
+    static const uint8_t aucCmd[] = {0x2A};
+    static const uint8_t aucParam[] = {0x00, 0xEF};
+    static const uint8_t aucExpected[] = {0x15, 0x40, 0x3D, 0xE0};
+    uint8_t aucOut[8];
+    disp_spi_9bit_enc_t tEnc;
+
+    memset(aucOut, 0xAA, sizeof(aucOut));
+    disp_spi_9bit_enc_init(&tEnc, aucOut);
+    disp_spi_9bit_enc_put(&tEnc, aucCmd, sizeof(aucCmd), false);
+    disp_spi_9bit_enc_put(&tEnc, aucParam, sizeof(aucParam), true);
+    CHECK_EQ(disp_spi_9bit_enc_finish(&tEnc), 27);
+    CHECK_EQ(tEnc.out - aucOut, sizeof(aucExpected));
+    CHECK(memcmp(aucOut, aucExpected, sizeof(aucExpected)) == 0);
+    CHECK_EQ(aucOut[sizeof(aucExpected)], 0xAA);
+}
+
+/* Every length up to a few groups, the odd ones leave a partial last byte. D/C changes
+ * at random points, put() is called once per run of equal D/C */
+static void test_round_trip(void)
+{
+    uint8_t aucIn[ROUND_TRIP_MAX];
+    bool abDcIn[ROUND_TRIP_MAX];
+    uint8_t aucPacked[DISP_SPI_9BIT_BYTES(ROUND_TRIP_MAX) + 1];
+    uint8_t aucOut[ROUND_TRIP_MAX];
+    bool abDcOut[ROUND_TRIP_MAX];
+
+    for (uint32_t uiLen = 1; uiLen <= ROUND_TRIP_MAX; uiLen++)
+    {
+        disp_spi_9bit_enc_t tEnc;
+        uint32_t uiRun = 0;
+
+        for (uint32_t i = 0; i < uiLen; i++)
+        {
+            aucIn[i] = test_rand();
+            abDcIn[i] = i == 0 ? false : (i % 5 == 3 ? !abDcIn[i - 1] : abDcIn[i - 1] || (test_rand() & 1));
+        }
+
+        memset(aucPacked, 0xAA, sizeof(aucPacked));
+        disp_spi_9bit_enc_init(&tEnc, aucPacked);
+        for (uint32_t i = 1; i <= uiLen; i++)
+        {
+            if (i == uiLen || abDcIn[i] != abDcIn[uiRun])
+            {
+                disp_spi_9bit_enc_put(&tEnc, &aucIn[uiRun], i - uiRun, abDcIn[uiRun]);
+                uiRun = i;
+            }
+        }
+
+        size_t uiBits = disp_spi_9bit_enc_finish(&tEnc);
+        CHECK_EQ(uiBits, uiLen * 9);
+        CHECK_EQ(tEnc.out - aucPacked, DISP_SPI_9BIT_BYTES(uiLen));
+        CHECK_EQ(aucPacked[DISP_SPI_9BIT_BYTES(uiLen)], 0xAA);
+        if (uiBits % 8)
+        {
+            /* Zero padded */
+            CHECK_EQ(aucPacked[uiBits / 8] & (0xFF >> (uiBits % 8)), 0);
+        }
+
+        memset(aucOut, 0, sizeof(aucOut));
+        CHECK_EQ(disp_spi_9bit_decode(aucPacked, uiBits, aucOut, abDcOut), uiLen);
+        CHECK(memcmp(aucOut, aucIn, uiLen) == 0);
+        CHECK(memcmp(abDcOut, abDcIn, uiLen * sizeof(bool)) == 0);
+
+        /* A partial unit at the end is not a byte */
+        CHECK_EQ(disp_spi_9bit_decode(aucPacked, uiBits - 1, aucOut, NULL), uiLen - 1);
+    }
+}
+
+static void wire_cb(const uint8_t* pucData, uint32_t uiBits, bool bDc, void* pArg)
+{
+    wire_t* ptWire = (wire_t*)pArg;
+
+    /* DC is in-band, every load is whole units and fits the FIFO */
+    CHECK_EQ(uiBits % 9, 0);
+    CHECK(uiBits <= LVGL_SPI_MAX_BITS);
+    if (ptWire->uiXfers < XFER_LOG_MAX)
+    {
+        ptWire->auiBits[ptWire->uiXfers] = uiBits;
+    }
+    ptWire->uiXfers++;
+    ili9341_decode_feed_9bit(&ptWire->tDec, pucData, uiBits);
+}
+
+static uint16_t test_color(uint32_t x, uint32_t y)
+{
+    return (uint16_t)((x * 7 + y * 331) % 0xFFFF + 1);
+}
+
+/* One flush of the area, checks the pixels and the loads it took: the window setup in one,
+ * then the colors in loads of LOAD_BYTES, the last one shorter */
+static void flush_9bit(const lv_area_t* ptArea, uint32_t uiWindowBytes)
+{
+    lv_color_t* ptColors = (lv_color_t*)s_auiColors;
+    uint32_t uiPx = lv_area_get_width(ptArea) * lv_area_get_height(ptArea);
+    uint32_t uiReady = mock_lvgl_get_flush_ready();
+    uint32_t i = 0;
+
+    for (int32_t y = ptArea->y1; y <= ptArea->y2; y++)
+    {
+        for (int32_t x = ptArea->x1; x <= ptArea->x2; x++)
+        {
+            uint8_t* pucPx = (uint8_t*)&ptColors[i++];
+            pucPx[0] = test_color(x, y) >> 8;
+            pucPx[1] = test_color(x, y) & 0xFF;
+        }
+    }
+
+    s_tWire.uiXfers = 0;
+    disp_driver_flush(mock_lvgl_get_disp_drv(), ptArea, ptColors);
+    CHECK_EQ(mock_lvgl_get_flush_ready(), uiReady + 1);
+
+    uint32_t uiBytes = uiPx * 2;
+    uint32_t uiLoads = (uiBytes + LOAD_BYTES - 1) / LOAD_BYTES;
+    CHECK_EQ(s_tWire.uiXfers, 1 + uiLoads);
+    CHECK_EQ(s_tWire.auiBits[0], uiWindowBytes * 9);
+    for (uint32_t l = 0; l < uiLoads && 1 + l < XFER_LOG_MAX; l++)
+    {
+        uint32_t uiLoad = l + 1 < uiLoads ? LOAD_BYTES : uiBytes - l * LOAD_BYTES;
+        CHECK_EQ(s_tWire.auiBits[1 + l], uiLoad * 9);
+    }
+
+    uint32_t uiBad = 0;
+    for (int32_t y = ptArea->y1; y <= ptArea->y2; y++)
+    {
+        for (int32_t x = ptArea->x1; x <= ptArea->x2; x++)
+        {
+            uiBad += s_ausFb[y * PANEL_W + x] != test_color(x, y);
+        }
+    }
+    CHECK_EQ(uiBad, 0);
+}
+
+static void test_ili9341_9bit(void)
+{
+    /* CASET and PASET with 4 parameters each and RAMWR, or RAMWR behind one of them */
+    const uint32_t uiFullWindow = 11;
+    const uint32_t uiOneAddr = 6;
+
+    mock_spi_reset(CONFIG_LV_DISP_PIN_DC);
+    ili9341_decode_init(&s_tWire.tDec, s_ausFb, PANEL_W, PANEL_H);
+    mock_spi_set_wire_cb(wire_cb, &s_tWire);
+
+    CHECK(disp_driver_select("ili9341"));
+    lvgl_driver_init();
+    disp_wait_for_pending_transactions();
+    CHECK_EQ(s_tWire.tDec.x2, PANEL_W - 1);
+    CHECK_EQ(s_tWire.tDec.y2, PANEL_H - 1);
+
+    /* Exactly one load */
+    lv_area_t tArea = {.x1 = 0, .y1 = 5, .x2 = LOAD_BYTES / 2 - 1, .y2 = 5};
+    flush_9bit(&tArea, uiFullWindow);
+
+    /* One load and a pixel on the same page, then the same columns on the next one */
+    tArea.x2 = LOAD_BYTES / 2;
+    flush_9bit(&tArea, uiOneAddr);
+    tArea.y1 = tArea.y2 = 6;
+    flush_9bit(&tArea, uiOneAddr);
+
+    /* Several full loads and a short one */
+    tArea = (lv_area_t){.x1 = 10, .y1 = 10, .x2 = 29, .y2 = 14};
+    flush_9bit(&tArea, uiFullWindow);
+
+    CHECK_EQ(s_tWire.tDec.clipped, 0);
+}
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+int main(void)
+{
+    test_known_stream();
+    test_round_trip();
+    test_ili9341_9bit();
+
+    return HOST_TEST_RESULT();
+}
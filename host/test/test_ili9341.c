@@ -0,0 +1,251 @@
+/**
+ * @file test_ili9341.c
+ * Flushes through disp_driver_flush() on the mock HSPI and replays the wire into
+ * a virtual 240x320 panel: the CASET/PASET/RAMWR sequence of every flush and the
+ * pixels it leaves behind have to match the area and the colors handed over.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "lvgl_helpers.h"
+#include "lvgl_tft/disp_driver.h"
+#include "lvgl_tft/disp_spi.h"
+#include "lvgl_tft/ili9341_decode.h"
+
+#include "mock_lvgl.h"
+#include "mock_spi.h"
+#include "host_test.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define PANEL_W         (240)
+#define PANEL_H         (320)
+#define CMD_LOG_MAX     (64)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+{
+    ili9341_decode_t tDec;
+    uint8_t aucCmds[CMD_LOG_MAX];   /* command bytes since the last reset of the log */
+    uint32_t uiCmds;
+} wire_t;
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static uint16_t s_ausFb[PANEL_W * PANEL_H];
+static wire_t s_tWire;
+
+/* One draw buffer of 240 x 30 and a spare word for the unaligned case */
+static uint32_t s_auiColors[(PANEL_W * 30 * sizeof(lv_color_t)) / 4 + 1];
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void wire_cb(const uint8_t* pucData, uint32_t uiBits, bool bDc, void* pArg)
+{
+    wire_t* ptWire = (wire_t*)pArg;
+
+    CHECK_EQ(uiBits % 8, 0);
+    for (uint32_t i = 0; !bDc && i < uiBits / 8; i++)
+    {
+        if (ptWire->uiCmds < CMD_LOG_MAX)
+        {
+            ptWire->aucCmds[ptWire->uiCmds] = pucData[i];
+        }
+        ptWire->uiCmds++;
+    }
+    ili9341_decode_feed(&ptWire->tDec, pucData, uiBits / 8, bDc);
+}
+
+/* Distinct for every pixel of the panel, never 0 so untouched pixels stand out */
+static uint16_t test_color(uint32_t x, uint32_t y)
+{
+    return (uint16_t)((x * 7 + y * 331) % 0xFFFF + 1);
+}
+
+/* Fill an area's colors the way LVGL renders them with LV_COLOR_16_SWAP: each pixel
+ * in memory is already the two bytes the panel gets, high byte first */
+static void fill_area(lv_color_t* ptColors, const lv_area_t* ptArea)
+{
+    uint32_t i = 0;
+
+    for (int32_t y = ptArea->y1; y <= ptArea->y2; y++)
+    {
+        for (int32_t x = ptArea->x1; x <= ptArea->x2; x++)
+        {
+            uint16_t usColor = test_color(x, y);
+            uint8_t* pucPx = (uint8_t*)&ptColors[i++];
+
+            pucPx[0] = usColor >> 8;
+            pucPx[1] = usColor & 0xFF;
+        }
+    }
+}
+
+static void flush(const lv_area_t* ptArea, lv_color_t* ptColors)
+{
+    uint32_t uiReady = mock_lvgl_get_flush_ready();
+
+    fill_area(ptColors, ptArea);
+    s_tWire.uiCmds = 0;
+    disp_driver_flush(mock_lvgl_get_disp_drv(), ptArea, ptColors);
+
+    /* The colors are still on their way, the SPI ISR signals the end */
+    disp_wait_for_pending_transactions();
+    CHECK_EQ(mock_lvgl_get_flush_ready(), uiReady + 1);
+}
+
+static void check_area(const lv_area_t* ptArea)
+{
+    uint32_t uiBad = 0;
+
+    for (int32_t y = ptArea->y1; y <= ptArea->y2; y++)
+    {
+        for (int32_t x = ptArea->x1; x <= ptArea->x2; x++)
+        {
+            uiBad += s_ausFb[y * PANEL_W + x] != test_color(x, y);
+        }
+    }
+    CHECK_EQ(uiBad, 0);
+}
+
+static void check_cmds(const uint8_t* pucExpected, uint32_t uiLen)
+{
+    CHECK_EQ(s_tWire.uiCmds, uiLen);
+    CHECK(s_tWire.uiCmds == uiLen && memcmp(s_tWire.aucCmds, pucExpected, uiLen) == 0);
+}
+
+static void test_init(void)
+{
+    mock_spi_reset(CONFIG_LV_DISP_PIN_DC);
+    ili9341_decode_init(&s_tWire.tDec, s_ausFb, PANEL_W, PANEL_H);
+    mock_spi_set_wire_cb(wire_cb, &s_tWire);
+
+    CHECK(disp_driver_select("ili9341"));
+    lvgl_driver_init();
+    disp_wait_for_pending_transactions();
+
+    /* The init table ends with a full screen window and an empty memory write */
+    CHECK_EQ(s_tWire.tDec.x1, 0);
+    CHECK_EQ(s_tWire.tDec.x2, PANEL_W - 1);
+    CHECK_EQ(s_tWire.tDec.y2, PANEL_H - 1);
+    CHECK_EQ(s_tWire.tDec.pixels, 0);
+    CHECK_EQ(mock_gpio_get_out(CONFIG_LV_DISP_PIN_RST), 1);
+}
+
+/* A small area, then the stripe below it: the column window is cached, so the second
+ * flush must not send CASET again */
+static void test_flush_window(void)
+{
+    static const uint8_t aucFull[] = {0x2A, 0x2B, 0x2C};
+    static const uint8_t aucSameCols[] = {0x2B, 0x2C};
+    lv_color_t* ptColors = (lv_color_t*)s_auiColors;
+    lv_area_t tArea = {.x1 = 10, .y1 = 20, .x2 = 25, .y2 = 27};
+    uint32_t uiPixels = s_tWire.tDec.pixels;
+
+    memset(s_ausFb, 0, sizeof(s_ausFb));
+    flush(&tArea, ptColors);
+    check_cmds(aucFull, sizeof(aucFull));
+    CHECK_EQ(s_tWire.tDec.x1, 10);
+    CHECK_EQ(s_tWire.tDec.x2, 25);
+    CHECK_EQ(s_tWire.tDec.y1, 20);
+    CHECK_EQ(s_tWire.tDec.y2, 27);
+    CHECK_EQ(s_tWire.tDec.pixels - uiPixels, 16 * 8);
+    check_area(&tArea);
+
+    /* Nothing outside the area was written */
+    uint32_t uiSet = 0;
+    for (uint32_t i = 0; i < PANEL_W * PANEL_H; i++)
+    {
+        uiSet += s_ausFb[i] != 0;
+    }
+    CHECK_EQ(uiSet, 16 * 8);
+
+    tArea.y1 = 28;
+    tArea.y2 = 35;
+    flush(&tArea, ptColors);
+    check_cmds(aucSameCols, sizeof(aucSameCols));
+    check_area(&tArea);
+}
+
+/* A whole draw buffer, many FIFO loads through both halves */
+static void test_flush_full_buffer(void)
+{
+    static const uint8_t aucFull[] = {0x2A, 0x2B, 0x2C};
+    lv_area_t tArea = {.x1 = 0, .y1 = 100, .x2 = PANEL_W - 1, .y2 = 129};
+
+    flush(&tArea, (lv_color_t*)s_auiColors);
+    check_cmds(aucFull, sizeof(aucFull));
+    check_area(&tArea);
+    CHECK_EQ(s_tWire.tDec.clipped, 0);
+}
+
+/* Colors that do not start on a word, the head bytes take the address phase */
+static void test_flush_unaligned(void)
+{
+    lv_area_t tArea = {.x1 = 3, .y1 = 200, .x2 = 103, .y2 = 206};
+    lv_color_t* ptColors = (lv_color_t*)((uint8_t*)s_auiColors + 2);
+
+    flush(&tArea, ptColors);
+    check_area(&tArea);
+}
+
+/* Queued flushes back to back, as LVGL does with two draw buffers */
+static void test_flush_back_to_back(void)
+{
+    static uint32_t s_auiSecond[(PANEL_W * 10 * sizeof(lv_color_t)) / 4];
+    lv_area_t tFirst = {.x1 = 0, .y1 = 240, .x2 = PANEL_W - 1, .y2 = 249};
+    lv_area_t tSecond = {.x1 = 0, .y1 = 250, .x2 = PANEL_W - 1, .y2 = 259};
+    uint32_t uiReady = mock_lvgl_get_flush_ready();
+
+    fill_area((lv_color_t*)s_auiColors, &tFirst);
+    fill_area((lv_color_t*)s_auiSecond, &tSecond);
+    disp_driver_flush(mock_lvgl_get_disp_drv(), &tFirst, (lv_color_t*)s_auiColors);
+    disp_driver_flush(mock_lvgl_get_disp_drv(), &tSecond, (lv_color_t*)s_auiSecond);
+    disp_wait_for_pending_transactions();
+
+    CHECK_EQ(mock_lvgl_get_flush_ready(), uiReady + 2);
+    check_area(&tFirst);
+    check_area(&tSecond);
+}
+
+/* A panel that is not registered falls back to LVGL_DISP_DEFAULT, flushes go on to it */
+static void test_select_unknown(void)
+{
+    lv_area_t tArea = {.x1 = 50, .y1 = 300, .x2 = 60, .y2 = 310};
+
+    CHECK(!disp_driver_select("st7789"));
+    CHECK(disp_driver_get() != NULL && strcmp(disp_driver_get()->name, LVGL_DISP_DEFAULT) == 0);
+
+    flush(&tArea, (lv_color_t*)s_auiColors);
+    check_area(&tArea);
+
+    CHECK(!disp_driver_select(NULL));
+    flush(&tArea, (lv_color_t*)s_auiColors);
+    check_area(&tArea);
+}
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+int main(void)
+{
+    test_init();
+    test_flush_window();
+    test_flush_full_buffer();
+    test_flush_unaligned();
+    test_flush_back_to_back();
+    test_select_unknown();
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,244 @@
+/**
+ * @file test_ili9488.c
+ * Flushes to the ILI9488 on the mock HSPI: the RGB666 the lookup tables expand into the
+ * chunk ring has to be the 3 bytes per pixel of the per-pixel math the tables replaced,
+ * for flushes that end inside the first chunk, on a chunk edge and after the ring wrapped,
+ * from a word aligned and from an odd source. LVGL renders with LV_COLOR_16_SWAP, the only
+ * setting the firmware builds.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "lvgl_helpers.h"
+#include "lvgl_tft/disp_driver.h"
+#include "lvgl_tft/disp_spi.h"
+#include "lvgl_tft/ili9488.h"
+
+#include "mock_lvgl.h"
+#include "mock_spi.h"
+#include "host_test.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+/* Largest draw buffer of the driver, 480 x 15 in landscape */
+#define BUF_PX          (480 * 15)
+
+#if !LV_COLOR_16_SWAP
+#error "the RGB666 path is only built with LV_COLOR_16_SWAP"
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+/* The memory write of the last flush as the panel takes it */
+typedef struct
+{
+    uint8_t ucCmd;
+    uint8_t aucParam[4];
+    uint32_t uiParams;
+    uint16_t usX1, usX2, usY1, usY2;
+    uint8_t aucPixels[BUF_PX * 3];
+    uint32_t uiBytes;                   /* RAMWR data bytes since the last command */
+    uint32_t uiOverflow;
+} wire_t;
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static wire_t s_tWire;
+static uint32_t s_auiColors[(BUF_PX * sizeof(lv_color_t)) / 4 + 1];
+static uint32_t s_uiSeed = 1;
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static uint8_t test_rand(void)
+{
+    s_uiSeed = s_uiSeed * 1103515245 + 12345;
+    return (uint8_t)(s_uiSeed >> 16);
+}
+
+static void wire_cb(const uint8_t* pucData, uint32_t uiBits, bool bDc, void* pArg)
+{
+    wire_t* ptWire = (wire_t*)pArg;
+
+    CHECK_EQ(uiBits % 8, 0);
+    for (uint32_t i = 0; i < uiBits / 8; i++)
+    {
+        if (!bDc)
+        {
+            ptWire->ucCmd = pucData[i];
+            ptWire->uiParams = 0;
+            ptWire->uiBytes = 0;
+        }
+        else if (ptWire->ucCmd == ILI9488_CMD_MEMORY_WRITE)
+        {
+            if (ptWire->uiBytes < sizeof(ptWire->aucPixels))
+            {
+                ptWire->aucPixels[ptWire->uiBytes] = pucData[i];
+            }
+            else
+            {
+                ptWire->uiOverflow++;
+            }
+            ptWire->uiBytes++;
+        }
+        else if (ptWire->uiParams < sizeof(ptWire->aucParam))
+        {
+            ptWire->aucParam[ptWire->uiParams++] = pucData[i];
+            if (ptWire->uiParams == 4 && ptWire->ucCmd == ILI9488_CMD_COLUMN_ADDRESS_SET)
+            {
+                ptWire->usX1 = (ptWire->aucParam[0] << 8) | ptWire->aucParam[1];
+                ptWire->usX2 = (ptWire->aucParam[2] << 8) | ptWire->aucParam[3];
+            }
+            else if (ptWire->uiParams == 4 && ptWire->ucCmd == ILI9488_CMD_PAGE_ADDRESS_SET)
+            {
+                ptWire->usY1 = (ptWire->aucParam[0] << 8) | ptWire->aucParam[1];
+                ptWire->usY2 = (ptWire->aucParam[2] << 8) | ptWire->aucParam[3];
+            }
+        }
+    }
+}
+
+/* The conversion before the lookup tables, one pixel at a time from the swapped RGB565 */
+static void rgb666_ref(const uint8_t* pucPx, uint8_t* pucOut)
+{
+    uint32_t uiLd = ((uint32_t)pucPx[0] << 8) | pucPx[1];
+
+    pucOut[0] = (uint8_t)(((uiLd & 0xF800) >> 8) | ((uiLd & 0x8000) >> 13));
+    pucOut[1] = (uint8_t)((uiLd & 0x07E0) >> 3);
+    pucOut[2] = (uint8_t)(((uiLd & 0x001F) << 3) | ((uiLd & 0x0010) >> 2));
+}
+
+/* Random colors from a byte offset of the buffer, a flush and the wire against the reference */
+static void flush_check(const lv_area_t* ptArea, uint32_t uiOffset)
+{
+    uint8_t* pucColors = (uint8_t*)s_auiColors + uiOffset;
+    uint32_t uiPx = lv_area_get_width(ptArea) * lv_area_get_height(ptArea);
+    uint32_t uiReady = mock_lvgl_get_flush_ready();
+
+    for (uint32_t i = 0; i < uiPx * 2; i++)
+    {
+        pucColors[i] = test_rand();
+    }
+
+    s_tWire.ucCmd = 0;
+    s_tWire.uiBytes = 0;
+    disp_driver_flush(mock_lvgl_get_disp_drv(), ptArea, (lv_color_t*)pucColors);
+
+    /* Queued behind the window commands, the last chunk signals the flush from the ISR */
+    disp_wait_for_pending_transactions();
+    CHECK_EQ(mock_lvgl_get_flush_ready(), uiReady + 1);
+
+    CHECK_EQ(s_tWire.usX1, ptArea->x1);
+    CHECK_EQ(s_tWire.usX2, ptArea->x2);
+    CHECK_EQ(s_tWire.usY1, ptArea->y1);
+    CHECK_EQ(s_tWire.usY2, ptArea->y2);
+    CHECK_EQ(s_tWire.uiBytes, uiPx * 3);
+    CHECK_EQ(s_tWire.uiOverflow, 0);
+
+    uint32_t uiBad = 0;
+    for (uint32_t i = 0; i < uiPx; i++)
+    {
+        uint8_t aucExpected[3];
+
+        rgb666_ref(&pucColors[2 * i], aucExpected);
+        uiBad += memcmp(&s_tWire.aucPixels[3 * i], aucExpected, 3) != 0;
+    }
+    CHECK_EQ(uiBad, 0);
+}
+
+static void test_init(void)
+{
+    mock_spi_reset(CONFIG_LV_DISP_PIN_DC);
+    mock_spi_set_wire_cb(wire_cb, &s_tWire);
+
+    CHECK(disp_driver_select("ili9488"));
+    lvgl_driver_init();
+    disp_wait_for_pending_transactions();
+
+    CHECK(disp_driver_buf_size() <= BUF_PX);
+    /* Lines of the wider side too, no more than the ILI9341 buffer of 240 x 30 */
+    CHECK(480U * disp_driver_get()->buf_lines <= 240U * 30U);
+    CHECK(disp_driver_get()->caps & DISP_DRIVER_FMT_RGB666);
+}
+
+/* Every pixel value through both tables, in the 4 pixel word loop and in the byte tail */
+static void test_all_colors(void)
+{
+    lv_area_t tArea = {.x1 = 0, .y1 = 0, .x2 = 255, .y2 = 0};
+    uint16_t* pusColors = (uint16_t*)s_auiColors;
+    uint32_t uiReady = mock_lvgl_get_flush_ready();
+
+    for (uint32_t uiBase = 0; uiBase < 0x10000; uiBase += 256)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint8_t* pucPx = (uint8_t*)&pusColors[i];
+
+            pucPx[0] = (uint8_t)((uiBase + i) >> 8);
+            pucPx[1] = (uint8_t)(uiBase + i);
+        }
+        s_tWire.uiBytes = 0;
+        disp_driver_flush(mock_lvgl_get_disp_drv(), &tArea, (lv_color_t*)pusColors);
+        disp_wait_for_pending_transactions();
+
+        uint32_t uiBad = 0;
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint8_t aucExpected[3];
+
+            rgb666_ref((uint8_t*)&pusColors[i], aucExpected);
+            uiBad += memcmp(&s_tWire.aucPixels[3 * i], aucExpected, 3) != 0;
+        }
+        CHECK_EQ(uiBad, 0);
+    }
+    CHECK_EQ(mock_lvgl_get_flush_ready(), uiReady + 256);
+}
+
+/* Sizes around the 128 pixel chunks and the 3 chunk ring, aligned and not */
+static void test_chunk_edges(void)
+{
+    /* Width and height, the pixels are 1 to 5 and around 128, 256 and 384 */
+    static const uint16_t ausSizes[][2] = {
+        {1, 1}, {3, 1}, {4, 1}, {5, 1}, {127, 1}, {128, 1}, {129, 1}, {255, 1}, {256, 1},
+        {127, 3}, {128, 3}, {77, 5}, {100, 10},
+    };
+
+    for (uint32_t s = 0; s < sizeof(ausSizes) / sizeof(ausSizes[0]); s++)
+    {
+        lv_area_t tArea = {.x1 = 7, .y1 = 3, .x2 = 7 + ausSizes[s][0] - 1, .y2 = 3 + ausSizes[s][1] - 1};
+
+        flush_check(&tArea, 0);
+        flush_check(&tArea, 2);
+        flush_check(&tArea, 1);
+    }
+}
+
+/* A whole draw buffer, as LVGL hands it over */
+static void test_full_buffer(void)
+{
+    const disp_driver_t* ptDrv = disp_driver_get();
+    lv_area_t tArea = {.x1 = 0, .y1 = 40, .x2 = ptDrv->hor_res - 1, .y2 = 40 + ptDrv->buf_lines - 1};
+
+    flush_check(&tArea, 0);
+}
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+int main(void)
+{
+    test_init();
+    test_all_colors();
+    test_chunk_edges();
+    test_full_buffer();
+
+    return HOST_TEST_RESULT();
+}
@@ -31,20 +31,49 @@
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "driver/hw_timer.h"
+#include "driver/soc.h"
 #include "cJSON.h"
 
 #include "esp_spiffs.h"
+#include "esp_ota_ops.h"
+#include "esp_heap_caps.h"
 
 #include "lvgl.h"
 #include "lvgl_helpers.h"
+#include "lvgl_blend.h"
 #include "lv_log.h"
 
 #include "lv_demo.h"
+#include "disp_spi.h"
+#include "touch_driver.h"
+#include "ui_cmd.h"
+#include "lvgl_log.h"
+#include "telemetry.h"
+#include "profiler.h"
 
 static const char *TAG = "app_main";
 
 #define LV_TICK_PERIOD_MS           (10)
 
+/* Task notification bits that wake guiTask before the next LVGL timer is due. The end of
+ * a flush is signalled with g_tFlushDone instead, gui_flush_wait_cb() only waits for that */
+#define GUI_NOTIFY_INPUT            (1 << 1)    /* touch IRQ */
+#define GUI_NOTIFY_REQUEST          (1 << 2)    /* another task changed the UI */
+#define GUI_NOTIFY_ALL              (GUI_NOTIFY_INPUT | GUI_NOTIFY_REQUEST)
+/* Longest sleep of guiTask, also when no LVGL timer is pending */
+#define GUI_IDLE_MAX_MS             (500)
+/* A draw buffer is out in a few ms, a flush still pending after this means a stuck bus */
+#define GUI_FLUSH_TIMEOUT_MS        (100)
+/* UI commands executed per loop before lv_timer_handler() */
+#define GUI_CMD_BATCH               (16)
+#define LVGL_SPI_BENCHMARK          (0)
+#define LVGL_FAST_BLEND             (1)
+#define LVGL_BLEND_BENCHMARK        (0)
+#define LVGL_BENCHMARK_SWEEP        (0)
+#define LVGL_TOUCH_INPUT            (0)
+#define LVGL_TELEMETRY              (1)
+#define LVGL_PROFILER               (LVGL_TELEMETRY && LV_TICK_CUSTOM)
+
 #define BOARD_TYPE_ESP01S			(0)
 #define BOARD_TYPE_ESP12E			(1)
 #define TARGET_BOARD_TYPE			BOARD_TYPE_ESP12E
@@ -156,14 +185,17 @@ static uint64_t			        g_ullDevID = BOARD_DEFAULT_ID;
 static char				        g_pcDevIDStr[20] = {0};
 static char 			        g_cDevName[128] = {0};
 static char 			        g_cDevTopic[128] = {0};
+/* Display driver to run, "panel" of the stored config */
+static char                     g_cPanel[16] = LVGL_DISP_DEFAULT;
 static const DEV_TYPE_E         g_eDevType = DEV_TYPE_SWITCH;
 static int                      g_iMqttClientState = 0;
 
 static unsigned char g_ucState;
-/* Creates a semaphore to handle concurrent call to lvgl stuff
- * If you wish to call *any* lvgl function from other threads/tasks
- * you should lock on the very same semaphore! */
-SemaphoreHandle_t xGuiSemaphore;
+/* Only guiTask calls lvgl. Other tasks post their UI updates with ui_cmd.h,
+ * guiTask executes them before lv_timer_handler() */
+static TaskHandle_t g_tGuiTask = NULL;
+/* Given by the SPI ISR once the colors of a flush are out */
+static SemaphoreHandle_t g_tFlushDone = NULL;
 lv_obj_t * label1 = NULL;
 
 static int xGPIOInit(unsigned int uiGPIOIndex)
@@ -426,6 +458,23 @@ End_Func:
     return iRet;
 }
 
+/* Mounts the storage partition and leaves it mounted for files used during the whole run */
+static int xMountStorage(void)
+{
+    esp_vfs_spiffs_conf_t config;
+    config.base_path = "/spiffs";
+    config.partition_label = NULL;
+    config.max_files = 5;
+    config.format_if_mount_failed = true;
+
+    esp_err_t tRet = esp_vfs_spiffs_register(&config);
+    if (tRet != ESP_OK && tRet != ESP_ERR_INVALID_STATE)
+    {
+        LOGE("esp_vfs_spiffs_register() fail!! ret:%s", esp_err_to_name(tRet));
+        return -1;
+    }
+    return 0;
+}
 
 static void _xSimpleTestTask(void* pParam)
 {
@@ -444,6 +493,7 @@ static void _xSimpleTestTask(void* pParam)
 	}
 }
 
+#if !LV_TICK_CUSTOM
 static uint32_t g_uiCnt = 0;
 
 static void lv_tick_task(void* arg) 
@@ -456,12 +506,85 @@ static void lv_tick_task(void* arg)
     }
 #endif
     (void) arg;
+    /* The benchmark verification runs on a simulated tick */
+    if (lv_demo_benchmark_tick_held())
+    {
+        return;
+    }
     lv_tick_inc(LV_TICK_PERIOD_MS);
 }
+#endif
+
+/* Inside the SPI ISR chain, spi_event_callback yields */
+static bool IRAM_ATTR xGuiFlushDoneISR(void)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    xSemaphoreGiveFromISR(g_tFlushDone, &xHigherPriorityTaskWoken);
+    return xHigherPriorityTaskWoken == pdTRUE;
+}
+
+#if LVGL_TOUCH_INPUT
+/* Returns true when guiTask has to run next, the caller yields at the end of its ISR */
+static bool IRAM_ATTR xGuiNotifyFromISR(uint32_t uiBits)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    if (g_tGuiTask)
+    {
+        xTaskNotifyFromISR(g_tGuiTask, uiBits, eSetBits, &xHigherPriorityTaskWoken);
+    }
+    return xHigherPriorityTaskWoken == pdTRUE;
+}
+
+/* Last thing the touch GPIO ISR does */
+static void IRAM_ATTR xGuiTouchISR(void)
+{
+    if (xGuiNotifyFromISR(GUI_NOTIFY_INPUT))
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+#endif
+
+/* Wakes guiTask after a UI command was posted */
+static void xGuiNotify(void)
+{
+    if (g_tGuiTask)
+    {
+        xTaskNotify(g_tGuiTask, GUI_NOTIFY_REQUEST, eSetBits);
+    }
+}
 
+/* LVGL calls this while a flush is still on the bus, sleep until the SPI ISR is done with it */
+static void gui_flush_wait_cb(lv_disp_drv_t* ptDrv)
+{
+    (void) ptDrv;
+#if LVGL_TELEMETRY
+    uint32_t uiStart = soc_get_ccount();
+#endif
+    /* A give left over from a flush LVGL did not wait for only costs one more round of
+     * LVGL's wait loop. Touch and UI requests stay pending for the main loop */
+    if (xSemaphoreTake(g_tFlushDone, pdMS_TO_TICKS(GUI_FLUSH_TIMEOUT_MS)) != pdTRUE)
+    {
+        LOGW("flush not done after %u ms!!", GUI_FLUSH_TIMEOUT_MS);
+    }
+#if LVGL_TELEMETRY
+    telemetry_add_wait(soc_get_ccount() - uiStart);
+#endif
+}
+
+#if LVGL_TELEMETRY
+/* Called by LVGL after every refresh, the benchmark chains it */
+static void gui_monitor_cb(lv_disp_drv_t* ptDrv, uint32_t uiTime, uint32_t uiPx)
+{
+    (void) ptDrv;
+    telemetry_frame(uiTime, uiPx);
+}
+#endif
+
+/* LVGL trace logs stay on, the line only gets copied here and goes out on the UART from the lvgl_log task */
 static void lv_log_print(const char* pcLog)
 {
-    ESP_LOGI(TAG, "%s", pcLog);
+    lvgl_log_text(ESP_LOG_INFO, "lvgl", pcLog);
 }
 
 void lvgl_init(void)
@@ -490,57 +613,73 @@ static void guiTask(void *pvParameter)
 {
     LOGI("Enter >>");
     (void) pvParameter;
-    xGuiSemaphore = xSemaphoreCreateMutex();
+    g_tGuiTask = xTaskGetCurrentTaskHandle();
+#if LVGL_TELEMETRY
+    telemetry_watch_task(g_tGuiTask);
+#endif
 
-    LOGI("DISP_BUF_SIZE:%u", DISP_BUF_SIZE);
+    /* The panel chosen at boot sizes the buffers and the display */
+    const disp_driver_t* ptPanel = disp_driver_get();
+    uint32_t size_in_px = disp_driver_buf_size();
+    LOGI("panel:%s buffer:%u px", ptPanel->name, size_in_px);
 #if 1
-    //lv_color_t* buf1 = heap_caps_malloc(DISP_BUF_SIZE * sizeof(lv_color_t), MALLOC_CAP_DMA);
-    lv_color_t* buf1 = (lv_color_t*)malloc(DISP_BUF_SIZE * sizeof(lv_color_t));
+    /* Word aligned draw buffers let lvgl_spi_transmit() hand the colors straight to the FIFO */
+    //lv_color_t* buf1 = heap_caps_malloc(size_in_px * sizeof(lv_color_t), MALLOC_CAP_DMA);
+    lv_color_t* buf1 = (lv_color_t*)heap_caps_malloc(size_in_px * sizeof(lv_color_t), MALLOC_CAP_32BIT);
     assert(buf1 != NULL);
+    assert(((uint32_t)buf1 & 0x3) == 0);
 
     /* Use double buffered when not working with monochrome displays */
-#ifndef CONFIG_LV_TFT_DISPLAY_MONOCHROME
-    //lv_color_t* buf2 = heap_caps_malloc(DISP_BUF_SIZE * sizeof(lv_color_t), MALLOC_CAP_DMA);
-    lv_color_t* buf2 = (lv_color_t*)malloc(DISP_BUF_SIZE * sizeof(lv_color_t));
+    lv_color_t* buf2 = NULL;
+    if ((ptPanel->caps & DISP_DRIVER_FMT_MONO) == 0)
+    {
+        //buf2 = heap_caps_malloc(size_in_px * sizeof(lv_color_t), MALLOC_CAP_DMA);
+        buf2 = (lv_color_t*)heap_caps_malloc(size_in_px * sizeof(lv_color_t), MALLOC_CAP_32BIT);
 
-    assert(buf2 != NULL);
-#else
-    static lv_color_t *buf2 = NULL;
-#endif
+        assert(buf2 != NULL);
+        assert(((uint32_t)buf2 & 0x3) == 0);
+    }
 
     static lv_disp_draw_buf_t disp_buf;
 
-    uint32_t size_in_px = DISP_BUF_SIZE;
-
-#if defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_IL3820         \
-    || defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_JD79653A    \
-    || defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_UC8151D     \
-    || defined CONFIG_LV_TFT_DISPLAY_CONTROLLER_SSD1306
-
-    /* Actual size in pixels, not bytes. */
-    size_in_px *= 8;
-#endif
-
     lv_disp_draw_buf_init(&disp_buf, buf1, buf2, size_in_px);
 
     lv_disp_drv_t disp_drv;
     lv_disp_drv_init(&disp_drv);
-    disp_drv.hor_res = LV_HOR_RES_MAX;
-    disp_drv.ver_res = LV_VER_RES_MAX;
+    disp_drv.hor_res = ptPanel->hor_res;
+    disp_drv.ver_res = ptPanel->ver_res;
     
     disp_drv.flush_cb = disp_driver_flush;
+    g_tFlushDone = xSemaphoreCreateBinary();
+    assert(g_tFlushDone != NULL);
+    disp_drv.wait_cb = gui_flush_wait_cb;
+    disp_spi_set_flush_done_cb(xGuiFlushDoneISR);
+#if LVGL_TELEMETRY
+    disp_drv.monitor_cb = gui_monitor_cb;
+#endif
+#if LVGL_FAST_BLEND
+    /* Color fills go through the pixel pair kernels of lvgl_blend.c */
+    disp_drv.draw_ctx_init = lvgl_blend_ctx_init;
+#endif
 
     /* When using a monochrome display we need to register the callbacks:
      * - rounder_cb
      * - set_px_cb */
-#ifdef CONFIG_LV_TFT_DISPLAY_MONOCHROME
-    disp_drv.rounder_cb = disp_driver_rounder;
-    disp_drv.set_px_cb = disp_driver_set_px;
-#endif
+    if (ptPanel->rounder)
+    {
+        disp_drv.rounder_cb = disp_driver_rounder;
+    }
+    if (ptPanel->set_px)
+    {
+        disp_drv.set_px_cb = disp_driver_set_px;
+    }
 
     disp_drv.draw_buf = &disp_buf;
     lv_disp_drv_register(&disp_drv);
 
+    /* With LV_TICK_CUSTOM lvgl_tick_get() reads the FreeRTOS tick count, no timer is needed
+     * and the hw_timer stays free for the profiler */
+#if !LV_TICK_CUSTOM
 #if 1
 #ifdef ESP32
     /* Create and start a periodic timer interrupt to call lv_tick_inc */
@@ -583,6 +722,7 @@ static void guiTask(void *pvParameter)
     }
 #endif
 #endif
+#endif
 
 #if 0
     /* use a pretty small demo for monochrome displays */
@@ -611,12 +751,51 @@ static void guiTask(void *pvParameter)
     }
 #else
 
+#endif
+
+#if LVGL_TOUCH_INPUT
+    /* Touch input, the pen IRQ wakes guiTask instead of waiting for the next indev poll */
+    touch_driver_init();
+    static lv_indev_drv_t indev_drv;
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.type = LV_INDEV_TYPE_POINTER;
+    indev_drv.read_cb = touch_driver_read;
+    lv_indev_drv_register(&indev_drv);
+    touch_driver_set_wake_cb(xGuiTouchISR);
+#endif
+
+#if LVGL_SPI_BENCHMARK
+    lvgl_spi_benchmark();
+#endif
+#if LVGL_BLEND_BENCHMARK
+    lvgl_blend_benchmark();
 #endif
 
     //lv_demo_stress();
    //LOGI("lv_demo_stress");
     //lv_demo_widgets();
+    /* Each panel keeps its own baseline and goldens, "null" is the rendering alone */
+    lv_demo_benchmark_set_target(disp_driver_get()->name);
+#ifdef LV_DEMO_BENCHMARK_STORE_PATH
+    /* Every benchmark run is kept on the storage partition and compared with the one before */
+    static char s_cVersion[32];
+    const esp_app_desc_t* ptDesc = esp_ota_get_app_description();
+    snprintf(s_cVersion, sizeof(s_cVersion), "%s %s", ptDesc->version, ptDesc->date);
+    lv_demo_benchmark_set_version(s_cVersion);
+    if (xMountStorage() != 0)
+    {
+        LOGE("benchmark results will not be stored!!");
+    }
+#endif
+#if LVGL_BENCHMARK_SWEEP
+    /* obj_num, img_num, size_pct; 0 keeps the default */
+    static const lv_demo_benchmark_step_t s_atSweep[] = {
+        {2, 1, 50}, {8, 0, 50}, {8, 0, 100}, {16, 4, 100}, {32, 8, 100},
+    };
+    lv_demo_benchmark_sweep(s_atSweep, sizeof(s_atSweep) / sizeof(s_atSweep[0]), NULL);
+#else
     lv_demo_benchmark();
+#endif
 
     /*
     lv_obj_t * label;
@@ -639,22 +818,44 @@ static void guiTask(void *pvParameter)
     lv_obj_center(label);
 */
     uint32_t uiCnt = 0;
+    uint32_t uiWaitMs = 0;
     while (1)
     {
-        /* Delay 1 tick (assumes FreeRTOS tick is 10ms */
-        vTaskDelay(pdMS_TO_TICKS(10));      
-#if 1
-        /* Try to take the semaphore, call lvgl related function on success */
-        if (pdTRUE == xSemaphoreTake(xGuiSemaphore, portMAX_DELAY)) 
+        /* Sleep until the next LVGL timer is due, a touch or a UI request wakes up earlier */
+        uint32_t uiBits = 0;
+        xTaskNotifyWait(0, GUI_NOTIFY_ALL, &uiBits, (uiWaitMs + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS);
+
+        if ((++uiCnt % 100) == 0)
+        {
+            LVGL_LOG(ESP_LOG_INFO, TAG, "uiCnt:%u cmd dropped:%u log dropped:%u", uiCnt, ui_cmd_get_dropped(),
+                     lvgl_log_get_dropped());
+        }
+        if (uiBits & GUI_NOTIFY_INPUT)
         {
-            if ((++uiCnt % 100) == 0)
+            /* Read the touch now rather than at the next indev poll */
+            lv_indev_t* ptIndev = NULL;
+            while ((ptIndev = lv_indev_get_next(ptIndev)) != NULL)
             {
-                LOGI("uiCnt:%u", uiCnt);
+                lv_timer_ready(ptIndev->driver->read_timer);
             }
-            lv_task_handler();
-            xSemaphoreGive(xGuiSemaphore);
         }
+
+        /* Updates of the same object were coalesced, all of them land in the next refresh */
+        uint32_t uiCmdLeft = ui_cmd_drain(GUI_CMD_BATCH);
+        uiWaitMs = lv_timer_handler();
+#if LVGL_TELEMETRY
+        telemetry_sample_sys();
 #endif
+
+        /* Go on with the rest of the commands right away, LV_NO_TIMER_READY when nothing is pending */
+        if (uiCmdLeft)
+        {
+            uiWaitMs = 0;
+        }
+        else if (uiWaitMs > GUI_IDLE_MAX_MS)
+        {
+            uiWaitMs = GUI_IDLE_MAX_MS;
+        }
     }
     LOGI("End <<");
 
@@ -702,6 +903,7 @@ void app_main(void)
             cJSON_AddItemToObject(pJObj, "name", cJSON_CreateString(strlen(g_cDevName) > 0 ? g_cDevName : "none"));
             cJSON_AddItemToObject(pJObj, "id", cJSON_CreateString(g_pcDevIDStr));
             cJSON_AddItemToObject(pJObj, "type", cJSON_CreateString(GET_TYPE_STR(g_eDevType)));
+            cJSON_AddItemToObject(pJObj, "panel", cJSON_CreateString(g_cPanel));
             xWriteConfigToFlash(pJObj);            
         }
     }
@@ -741,6 +943,17 @@ void app_main(void)
                 }
             }
         }
+
+        pJTemp = cJSON_GetObjectItem(pJObj, "panel");
+        pcTemp = NULL;
+        if (pJTemp)
+        {
+            pcTemp = cJSON_GetStringValue(pJTemp);
+            if (pcTemp && strlen(pcTemp))
+            {
+                strncpy(g_cPanel, pcTemp, sizeof(g_cPanel) - 1);
+            }
+        }
     }
 
     if (pJObj)
@@ -749,7 +962,9 @@ void app_main(void)
         pJObj = NULL;
     }
     
-	LOGI("name:%s id:%s type:%s", g_cDevName, g_pcDevIDStr, GET_TYPE_STR(g_eDevType));
+	LOGI("name:%s id:%s type:%s panel:%s", g_cDevName, g_pcDevIDStr, GET_TYPE_STR(g_eDevType), g_cPanel);
+    /* Before lvgl_init(), the SPI clock and the panel init depend on it */
+    disp_driver_select(g_cPanel);
     
     /* This helper function configures Wi-Fi or Ethernet, as selected in menuconfig.
     * Read "Establishing Wi-Fi or Ethernet Connection" section in
@@ -768,15 +983,27 @@ void app_main(void)
 
 	xSetTime(tTime);
     
+    lvgl_log_init(tskIDLE_PRIORITY + 1);
     lvgl_init();
 
     LOGI("configMINIMAL_STACK_SIZE:%u", configMINIMAL_STACK_SIZE);
-    xTaskCreate(_xSimpleTestTask, "_xSimpleTestTask", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 2, NULL);
+    TaskHandle_t tTestTask = NULL;
+    xTaskCreate(_xSimpleTestTask, "_xSimpleTestTask", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 2, &tTestTask);
+#if LVGL_TELEMETRY
+    /* "tlm csv" or "tlm bin" on the console dumps the frame and memory records */
+    telemetry_watch_task(tTestTask);
+    telemetry_init(tskIDLE_PRIORITY + 1);
+#endif
+#if LVGL_PROFILER
+    /* "prof start", run the scene of interest, "prof dump" */
+    profiler_init();
+#endif
     /* If you want to use a task to create the graphic, you NEED to create a Pinned task
      * Otherwise there can be problem such as memory corruption and so on.
      * NOTE: When not using Wi-Fi nor Bluetooth you can pin the guiTask to core 0 */
     //xTaskCreatePinnedToCore(guiTask, "gui", 4096*2, NULL, 0, NULL, 1);
 
+    ui_cmd_init(xGuiNotify);
     BaseType_t iRet = xTaskCreate(guiTask, "gui", 4096*2, NULL, tskIDLE_PRIORITY + 4, NULL);
     if (iRet != pdPASS)
     {
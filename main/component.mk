@@ -24,4 +24,7 @@ COMPONENT_ADD_INCLUDEDIRS += ../app/lv_examples/src/lv_demo_stress/assets
 COMPONENT_ADD_INCLUDEDIRS += ../app/lv_examples/src/lv_demo_stress
 
 COMPONENT_ADD_INCLUDEDIRS += ../app/lv_examples/src/lv_demo_benchmark/assets
-COMPONENT_ADD_INCLUDEDIRS += ../app/lv_examples/src/lv_demo_benchmark
\ No newline at end of file
+COMPONENT_ADD_INCLUDEDIRS += ../app/lv_examples/src/lv_demo_benchmark
+
+## functions placed into IRAM
+COMPONENT_ADD_LDFRAGMENTS += linker.lf
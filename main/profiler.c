@@ -0,0 +1,253 @@
+/**
+ * @file profiler.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/xtensa_context.h"
+
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "driver/hw_timer.h"
+#include "driver/uart.h"
+
+#include "lvgl.h"
+#include "telemetry.h"
+#include "profiler.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TAG "profiler"
+
+#define PROFILER_UART               ((uart_port_t)CONFIG_ESP_CONSOLE_UART_NUM)
+/* Words above the ISR's stack pointer searched for the interrupt frame */
+#define PROFILER_SCAN_WORDS         (64)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+{
+    uint32_t uiPc;
+    uint32_t uiCaller;              /* 0 when the frame was not found */
+} profiler_sample_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void profiler_isr(void* pArg);
+#if PROFILER_CALLER
+static uint32_t profiler_caller(uint32_t uiPc);
+#endif
+static int profiler_cmp(const void* pA, const void* pB);
+static void profiler_cmd(const char* pcArgs);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+/* Only the ISR writes while sampling, the dump stops the timer before reading */
+static profiler_sample_t* s_ptBuf = NULL;
+static volatile uint32_t s_uiCnt = 0;
+static volatile uint32_t s_uiLost = 0;
+static uint32_t s_uiHz = 0;
+static bool s_bRunning = false;
+
+/**********************
+ *      MACROS
+ **********************/
+/* IRAM and the flash cache window, where a return address can point */
+#define IS_CODE(a)          (((a) >= 0x40100000 && (a) < 0x40100000 + CONFIG_SOC_IRAM_SIZE) || \
+                             ((a) >= 0x40200000 && (a) < 0x40300000))
+#define IS_STACK(a)         ((a) >= 0x3FFE8000 && (a) < 0x40000000 && ((a) & 0xF) == 0)
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void profiler_init(void)
+{
+    telemetry_add_cmd("prof", profiler_cmd);
+}
+
+bool profiler_start(uint32_t uiHz)
+{
+#if !LV_TICK_CUSTOM
+    (void) uiHz;
+    ESP_LOGE(TAG, "hw_timer drives the LVGL tick, set LV_TICK_CUSTOM!!");
+    return false;
+#else
+    if (uiHz < PROFILER_MIN_HZ || uiHz > PROFILER_MAX_HZ)
+    {
+        ESP_LOGE(TAG, "rate %u out of %u..%u!!", uiHz, PROFILER_MIN_HZ, PROFILER_MAX_HZ);
+        return false;
+    }
+    if (s_ptBuf == NULL)
+    {
+        s_ptBuf = (profiler_sample_t*)malloc(PROFILER_SAMPLES_MAX * sizeof(profiler_sample_t));
+        if (s_ptBuf == NULL)
+        {
+            ESP_LOGE(TAG, "no memory for %u samples!!", PROFILER_SAMPLES_MAX);
+            return false;
+        }
+    }
+
+    profiler_stop();
+    s_uiCnt = 0;
+    s_uiLost = 0;
+    s_uiHz = uiHz;
+
+    if (hw_timer_init(profiler_isr, NULL) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "hw_timer_init fail!!");
+        return false;
+    }
+    if (hw_timer_alarm_us(1000000 / uiHz, true) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "hw_timer_alarm_us fail!!");
+        hw_timer_deinit();
+        return false;
+    }
+    s_bRunning = true;
+    ESP_LOGI(TAG, "sampling at %u Hz, full after %u ms", uiHz, PROFILER_SAMPLES_MAX * 1000 / uiHz);
+    return true;
+#endif
+}
+
+void profiler_stop(void)
+{
+    if (s_bRunning)
+    {
+        hw_timer_deinit();
+        s_bRunning = false;
+    }
+}
+
+void profiler_dump(void)
+{
+    char cLine[48];
+    int iLen;
+
+    profiler_stop();
+    uint32_t uiCnt = LV_MIN(s_uiCnt, PROFILER_SAMPLES_MAX);
+
+    /* Sorted, equal samples become one line, which keeps the dump short at the console baud rate */
+    if (uiCnt)
+    {
+        qsort(s_ptBuf, uiCnt, sizeof(profiler_sample_t), profiler_cmp);
+    }
+
+    iLen = snprintf(cLine, sizeof(cLine), "prof,begin,%u,%u,%u\n", uiCnt, s_uiHz, s_uiLost);
+    uart_write_bytes(PROFILER_UART, cLine, iLen);
+
+    for (uint32_t i = 0; i < uiCnt;)
+    {
+        uint32_t j = i + 1;
+        while (j < uiCnt && profiler_cmp(&s_ptBuf[i], &s_ptBuf[j]) == 0)
+        {
+            j++;
+        }
+        iLen = snprintf(cLine, sizeof(cLine), "prof,%08x,%08x,%u\n", s_ptBuf[i].uiPc, s_ptBuf[i].uiCaller, j - i);
+        uart_write_bytes(PROFILER_UART, cLine, iLen);
+        i = j;
+    }
+
+    iLen = snprintf(cLine, sizeof(cLine), "prof,end\n");
+    uart_write_bytes(PROFILER_UART, cLine, iLen);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/* hw_timer callback, runs from the level 1 interrupt dispatcher. EPC1 still holds the PC the
+   interrupt was taken at: the LX106 runs the CALL0 ABI, so no window exception can overwrite it */
+static void IRAM_ATTR profiler_isr(void* pArg)
+{
+    uint32_t uiPc;
+    __asm__ __volatile__("rsr %0, epc1" : "=a"(uiPc));
+    (void) pArg;
+
+    uint32_t uiCnt = s_uiCnt;
+    if (uiCnt >= PROFILER_SAMPLES_MAX)
+    {
+        s_uiLost++;
+        return;
+    }
+    s_ptBuf[uiCnt].uiPc = uiPc;
+#if PROFILER_CALLER
+    s_ptBuf[uiCnt].uiCaller = profiler_caller(uiPc);
+#else
+    s_ptBuf[uiCnt].uiCaller = 0;
+#endif
+    s_uiCnt = uiCnt + 1;
+}
+
+#if PROFILER_CALLER
+/* The dispatcher saved the interrupted registers in an XtExcFrame somewhere above us, the PC
+   we read from EPC1 and a saved SP that looks like one mark it. A0 of a leaf function is its
+   return address, for other functions it is whatever they last called, so the caller is a hint
+   and 0 when it does not look like code */
+static uint32_t IRAM_ATTR profiler_caller(uint32_t uiPc)
+{
+    uint32_t* puiSp;
+    __asm__ __volatile__("mov %0, a1" : "=a"(puiSp));
+
+    for (uint32_t i = 0; i < PROFILER_SCAN_WORDS; i++)
+    {
+        const XtExcFrame* ptFrame = (const XtExcFrame*)((uint8_t*)&puiSp[i] - offsetof(XtExcFrame, pc));
+        if (puiSp[i] == uiPc && IS_STACK((uint32_t)ptFrame->a1))
+        {
+            uint32_t uiA0 = (uint32_t)ptFrame->a0;
+            return IS_CODE(uiA0) ? uiA0 : 0;
+        }
+    }
+    return 0;
+}
+#endif
+
+static int profiler_cmp(const void* pA, const void* pB)
+{
+    const profiler_sample_t* ptA = (const profiler_sample_t*)pA;
+    const profiler_sample_t* ptB = (const profiler_sample_t*)pB;
+
+    if (ptA->uiPc != ptB->uiPc)
+    {
+        return ptA->uiPc < ptB->uiPc ? -1 : 1;
+    }
+    if (ptA->uiCaller != ptB->uiCaller)
+    {
+        return ptA->uiCaller < ptB->uiCaller ? -1 : 1;
+    }
+    return 0;
+}
+
+static void profiler_cmd(const char* pcArgs)
+{
+    if (strncmp(pcArgs, "start", 5) == 0)
+    {
+        uint32_t uiHz = pcArgs[5] == ' ' ? (uint32_t)atoi(&pcArgs[6]) : PROFILER_DEFAULT_HZ;
+        profiler_start(uiHz);
+    }
+    else if (strcmp(pcArgs, "stop") == 0)
+    {
+        profiler_stop();
+    }
+    else if (strcmp(pcArgs, "dump") == 0)
+    {
+        profiler_dump();
+    }
+    else
+    {
+        ESP_LOGW(TAG, "unknown argument:%s, use prof start [hz]|stop|dump", pcArgs);
+    }
+}
@@ -0,0 +1,64 @@
+/**
+ * @file profiler.h
+ * Statistical CPU profiler, samples the interrupted PC from the hw_timer interrupt
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdbool.h>
+#include <stdint.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define PROFILER_SAMPLES_MAX        (512)   /* the buffer is allocated by the first start */
+#define PROFILER_DEFAULT_HZ         (1000)
+#define PROFILER_MIN_HZ             (100)
+#define PROFILER_MAX_HZ             (10000)
+/* Look for the interrupted A0 in the interrupt frame, i.e. the caller of a leaf function.
+   Costs a short stack scan per sample */
+#define PROFILER_CALLER             (1)
+
+/* Console commands, see telemetry_add_cmd():
+   "prof start [hz]"  clear the buffer and sample until it is full or stopped
+   "prof stop"
+   "prof dump"        "prof,begin,<samples>,<hz>,<lost>", then "prof,<pc>,<caller>,<count>"
+                      lines sorted by pc, then "prof,end".
+   tools/prof_symbolize.py turns a capture of the dump into a flat and a caller profile. */
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* Register the "prof" console command. The hw_timer is only taken by profiler_start(),
+   it cannot be used while it drives the LVGL tick (LV_TICK_CUSTOM 0) */
+void profiler_init(void);
+
+/* Clear the buffer and start sampling at uiHz. Code running with interrupts masked,
+   i.e. critical sections and other ISRs, is never sampled */
+bool profiler_start(uint32_t uiHz);
+void profiler_stop(void);
+
+/* Write the samples aggregated by (pc, caller) to the console UART, stops a running profile */
+void profiler_dump(void);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PROFILER_H */
@@ -0,0 +1,389 @@
+/**
+ * @file telemetry.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_system.h"
+#include "driver/soc.h"
+#include "driver/uart.h"
+
+#include "lvgl.h"
+#include "lvgl_helpers.h"
+#include "telemetry.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TAG "telemetry"
+
+#define TELEMETRY_UART              ((uart_port_t)CONFIG_ESP_CONSOLE_UART_NUM)
+#define TELEMETRY_UART_RX_SIZE      (256)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+{
+    const char* pcName;
+    telemetry_cmd_cb_t pfnCb;
+} telemetry_cmd_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void telemetry_put(const telemetry_rec_t* ptRec);
+static void telemetry_hold(bool bHold);
+static void telemetry_write(const void* pData, uint32_t uiLen);
+static uint16_t telemetry_fletcher16(uint16_t usSum, const uint8_t* pucData, uint32_t uiLen);
+static void telemetry_cmd_tlm(const char* pcArgs);
+static void telemetry_cmd_exec(const char* pcLine);
+static void telemetry_cmd_task(void* pvParameter);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+/* guiTask is the only writer. The dumps hold the ring rather than copying it, a dump at the
+   console baud rate takes longer than the ring lasts at full frame rate */
+static telemetry_rec_t s_atRing[TELEMETRY_RING_SIZE];
+static uint32_t s_uiHead = 0;               /* records written */
+static uint32_t s_uiTail = 0;               /* first record after the last clear */
+static bool s_bHold = false;
+static uint32_t s_uiHeldDropped = 0;
+
+static TaskHandle_t s_aptTask[TELEMETRY_TASKS_MAX];
+static telemetry_cmd_t s_atCmd[TELEMETRY_CMDS_MAX];
+static uint32_t s_uiWaitCycles = 0;
+static TickType_t s_tSysLast = 0;
+static uint16_t s_usSampleUs = 0;
+#if LVGL_FLUSH_STATS
+static lvgl_flush_stats_t s_tFlushLast;
+#endif
+
+/**********************
+ *      MACROS
+ **********************/
+#define RING_FIRST()        LV_MAX(s_uiTail, s_uiHead > TELEMETRY_RING_SIZE ? s_uiHead - TELEMETRY_RING_SIZE : 0)
+#define RING_AT(i)          (&s_atRing[(i) % TELEMETRY_RING_SIZE])
+#define NOW_MS()            ((uint32_t)xTaskGetTickCount() * portTICK_PERIOD_MS)
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void telemetry_init(uint32_t uiPriority)
+{
+    /* The console keeps writing through its own path, the driver is only needed to read commands */
+    if (uart_driver_install(TELEMETRY_UART, TELEMETRY_UART_RX_SIZE, 0, 0, NULL, 0) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "uart_driver_install fail!!");
+        return;
+    }
+    telemetry_add_cmd("tlm", telemetry_cmd_tlm);
+    if (xTaskCreate(telemetry_cmd_task, "telemetry", 2048, NULL, uiPriority, NULL) != pdPASS)
+    {
+        ESP_LOGE(TAG, "xTaskCreate telemetry fail!!");
+    }
+}
+
+void telemetry_add_cmd(const char* pcName, telemetry_cmd_cb_t pfnCb)
+{
+    for (uint32_t i = 0; i < TELEMETRY_CMDS_MAX; i++)
+    {
+        if (s_atCmd[i].pcName == NULL || strcmp(s_atCmd[i].pcName, pcName) == 0)
+        {
+            s_atCmd[i].pcName = pcName;
+            s_atCmd[i].pfnCb = pfnCb;
+            return;
+        }
+    }
+    ESP_LOGE(TAG, "no room for command %s!!", pcName);
+}
+
+void telemetry_watch_task(TaskHandle_t ptTask)
+{
+    for (uint32_t i = 0; i < TELEMETRY_TASKS_MAX; i++)
+    {
+        if (s_aptTask[i] == NULL || s_aptTask[i] == ptTask)
+        {
+            s_aptTask[i] = ptTask;
+            return;
+        }
+    }
+    ESP_LOGE(TAG, "no room to watch task %p!!", ptTask);
+}
+
+void telemetry_add_wait(uint32_t uiCycles)
+{
+    s_uiWaitCycles += uiCycles;
+}
+
+void telemetry_frame(uint32_t uiRefrMs, uint32_t uiPx)
+{
+    telemetry_rec_t tRec;
+    uint32_t uiFlushUs = 0;
+    uint32_t uiWaitUs = s_uiWaitCycles / LVGL_CYCLES_PER_US;
+
+    memset(&tRec, 0, sizeof(tRec));
+    tRec.uiTime = NOW_MS();
+    tRec.usType = TELEMETRY_REC_FRAME;
+    s_uiWaitCycles = 0;
+
+#if LVGL_FLUSH_STATS
+    /* The counters only grow, the flushes since the last refresh belong to this one */
+    lvgl_flush_stats_t tStats;
+    lvgl_get_flush_stats(&tStats);
+    tRec.usAreas = (uint16_t)LV_MIN(tStats.uiFlushes - s_tFlushLast.uiFlushes, 0xffff);
+    uiFlushUs = (uint32_t)((tStats.ullFlushCycles - s_tFlushLast.ullFlushCycles) / LVGL_CYCLES_PER_US);
+    s_tFlushLast = tStats;
+#endif
+
+    /* LVGL only measures the refresh in ticks, what is left after the flushes is rendering */
+    uint32_t uiRefrUs = uiRefrMs * 1000;
+    tRec.u.tFrame.uiRenderUs = uiRefrUs > uiFlushUs + uiWaitUs ? uiRefrUs - uiFlushUs - uiWaitUs : 0;
+    tRec.u.tFrame.uiFlushUs = uiFlushUs;
+    tRec.u.tFrame.uiWaitUs = uiWaitUs;
+    tRec.u.tFrame.uiPx = uiPx;
+    telemetry_put(&tRec);
+}
+
+void telemetry_sample_sys(void)
+{
+    TickType_t tNow = xTaskGetTickCount();
+    if ((uint32_t)(tNow - s_tSysLast) * portTICK_PERIOD_MS < TELEMETRY_SYS_PERIOD_MS)
+    {
+        return;
+    }
+    s_tSysLast = tNow;
+
+    /* lv_mem_monitor() walks the LVGL heap and the watermarks scan the stacks, that is why this
+       runs once a period and not per refresh. The cost goes into the next record */
+    uint32_t uiStart = soc_get_ccount();
+    telemetry_rec_t tRec;
+    lv_mem_monitor_t tMon;
+
+    memset(&tRec, 0, sizeof(tRec));
+    tRec.uiTime = (uint32_t)tNow * portTICK_PERIOD_MS;
+    tRec.usType = TELEMETRY_REC_SYS;
+    tRec.u.tSys.uiFreeHeap = esp_get_free_heap_size();
+
+    lv_mem_monitor(&tMon);
+    tRec.u.tSys.uiLvFree = tMon.free_size;
+    tRec.u.tSys.ucLvFragPct = tMon.frag_pct;
+    tRec.u.tSys.ucLvUsedPct = tMon.used_pct;
+
+    for (uint32_t i = 0; i < TELEMETRY_TASKS_MAX; i++)
+    {
+        if (s_aptTask[i])
+        {
+            uint32_t uiFree = uxTaskGetStackHighWaterMark(s_aptTask[i]) * sizeof(StackType_t);
+            tRec.u.tSys.ausStackFree[i] = (uint16_t)LV_MIN(uiFree, 0xffff);
+        }
+    }
+    tRec.u.tSys.usSampleUs = s_usSampleUs;
+    telemetry_put(&tRec);
+
+    s_usSampleUs = (uint16_t)LV_MIN((soc_get_ccount() - uiStart) / LVGL_CYCLES_PER_US, 0xffff);
+}
+
+void telemetry_dump_csv(void)
+{
+    char cLine[128];
+    int iLen;
+
+    telemetry_hold(true);
+    uint32_t uiFirst = RING_FIRST();
+
+    iLen = snprintf(cLine, sizeof(cLine), "tlm,begin,%u,%u\n", s_uiHead - uiFirst, s_uiHeldDropped);
+    telemetry_write(cLine, iLen);
+    iLen = snprintf(cLine, sizeof(cLine), "tlm,#F,time_ms,areas,render_us,flush_us,wait_us,px\n");
+    telemetry_write(cLine, iLen);
+    iLen = snprintf(cLine, sizeof(cLine), "tlm,#S,time_ms,heap,lv_free,lv_frag_pct,lv_used_pct,sample_us");
+    for (uint32_t i = 0; i < TELEMETRY_TASKS_MAX; i++)
+    {
+        iLen += snprintf(cLine + iLen, sizeof(cLine) - iLen, ",stack_%s",
+                         s_aptTask[i] ? pcTaskGetName(s_aptTask[i]) : "none");
+    }
+    iLen += snprintf(cLine + iLen, sizeof(cLine) - iLen, "\n");
+    telemetry_write(cLine, LV_MIN(iLen, (int)sizeof(cLine) - 1));
+
+    for (uint32_t i = uiFirst; i < s_uiHead; i++)
+    {
+        const telemetry_rec_t* ptRec = RING_AT(i);
+        if (ptRec->usType == TELEMETRY_REC_FRAME)
+        {
+            iLen = snprintf(cLine, sizeof(cLine), "tlm,F,%u,%u,%u,%u,%u,%u\n", ptRec->uiTime, ptRec->usAreas,
+                            ptRec->u.tFrame.uiRenderUs, ptRec->u.tFrame.uiFlushUs, ptRec->u.tFrame.uiWaitUs,
+                            ptRec->u.tFrame.uiPx);
+        }
+        else
+        {
+            iLen = snprintf(cLine, sizeof(cLine), "tlm,S,%u,%u,%u,%u,%u,%u", ptRec->uiTime,
+                            ptRec->u.tSys.uiFreeHeap, ptRec->u.tSys.uiLvFree, ptRec->u.tSys.ucLvFragPct,
+                            ptRec->u.tSys.ucLvUsedPct, ptRec->u.tSys.usSampleUs);
+            for (uint32_t j = 0; j < TELEMETRY_TASKS_MAX; j++)
+            {
+                iLen += snprintf(cLine + iLen, sizeof(cLine) - iLen, ",%u", ptRec->u.tSys.ausStackFree[j]);
+            }
+            iLen += snprintf(cLine + iLen, sizeof(cLine) - iLen, "\n");
+        }
+        telemetry_write(cLine, iLen);
+    }
+
+    iLen = snprintf(cLine, sizeof(cLine), "tlm,end\n");
+    telemetry_write(cLine, iLen);
+    telemetry_hold(false);
+}
+
+void telemetry_dump_bin(void)
+{
+    uint8_t aucHdr[8];
+    uint16_t usSum = 0;
+
+    telemetry_hold(true);
+    uint32_t uiFirst = RING_FIRST();
+    uint16_t usCnt = (uint16_t)(s_uiHead - uiFirst);
+    uint16_t usSize = sizeof(telemetry_rec_t);
+
+    memcpy(aucHdr, TELEMETRY_BIN_MAGIC, 4);
+    memcpy(&aucHdr[4], &usSize, 2);
+    memcpy(&aucHdr[6], &usCnt, 2);
+    telemetry_write(aucHdr, sizeof(aucHdr));
+
+    for (uint32_t i = uiFirst; i < s_uiHead; i++)
+    {
+        const telemetry_rec_t* ptRec = RING_AT(i);
+        usSum = telemetry_fletcher16(usSum, (const uint8_t*)ptRec, sizeof(*ptRec));
+        telemetry_write(ptRec, sizeof(*ptRec));
+    }
+    telemetry_write(&usSum, sizeof(usSum));
+    telemetry_write("\n", 1);
+    telemetry_hold(false);
+}
+
+void telemetry_clear(void)
+{
+    portENTER_CRITICAL();
+    s_uiTail = s_uiHead;
+    s_uiHeldDropped = 0;
+    portEXIT_CRITICAL();
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void telemetry_put(const telemetry_rec_t* ptRec)
+{
+    portENTER_CRITICAL();
+    if (s_bHold)
+    {
+        s_uiHeldDropped++;
+    }
+    else
+    {
+        *RING_AT(s_uiHead) = *ptRec;
+        s_uiHead++;
+    }
+    portEXIT_CRITICAL();
+}
+
+/* Records taken while a dump is running are dropped and counted, the dump sees a fixed ring */
+static void telemetry_hold(bool bHold)
+{
+    portENTER_CRITICAL();
+    s_bHold = bHold;
+    portEXIT_CRITICAL();
+}
+
+static void telemetry_write(const void* pData, uint32_t uiLen)
+{
+    uart_write_bytes(TELEMETRY_UART, (const char*)pData, uiLen);
+}
+
+static uint16_t telemetry_fletcher16(uint16_t usSum, const uint8_t* pucData, uint32_t uiLen)
+{
+    uint32_t uiSum1 = usSum & 0xff;
+    uint32_t uiSum2 = usSum >> 8;
+
+    for (uint32_t i = 0; i < uiLen; i++)
+    {
+        uiSum1 = (uiSum1 + pucData[i]) % 255;
+        uiSum2 = (uiSum2 + uiSum1) % 255;
+    }
+    return (uint16_t)((uiSum2 << 8) | uiSum1);
+}
+
+static void telemetry_cmd_tlm(const char* pcArgs)
+{
+    if (strcmp(pcArgs, "csv") == 0)
+    {
+        telemetry_dump_csv();
+    }
+    else if (strcmp(pcArgs, "bin") == 0)
+    {
+        telemetry_dump_bin();
+    }
+    else if (strcmp(pcArgs, "clear") == 0)
+    {
+        telemetry_clear();
+    }
+    else
+    {
+        ESP_LOGW(TAG, "unknown argument:%s, use tlm csv|bin|clear", pcArgs);
+    }
+}
+
+static void telemetry_cmd_exec(const char* pcLine)
+{
+    const char* pcArgs = strchr(pcLine, ' ');
+    uint32_t uiLen = pcArgs ? (uint32_t)(pcArgs - pcLine) : strlen(pcLine);
+
+    for (uint32_t i = 0; i < TELEMETRY_CMDS_MAX && s_atCmd[i].pcName; i++)
+    {
+        if (strlen(s_atCmd[i].pcName) == uiLen && strncmp(s_atCmd[i].pcName, pcLine, uiLen) == 0)
+        {
+            s_atCmd[i].pfnCb(pcArgs ? pcArgs + 1 : "");
+            return;
+        }
+    }
+    ESP_LOGW(TAG, "unknown command:%s", pcLine);
+}
+
+static void telemetry_cmd_task(void* pvParameter)
+{
+    (void) pvParameter;
+    char cLine[TELEMETRY_CMD_LINE_MAX];
+    uint32_t uiLen = 0;
+    uint8_t ucChar;
+
+    while (1)
+    {
+        if (uart_read_bytes(TELEMETRY_UART, &ucChar, 1, portMAX_DELAY) != 1)
+        {
+            continue;
+        }
+        if (ucChar == '\r' || ucChar == '\n')
+        {
+            cLine[uiLen] = '\0';
+            if (uiLen)
+            {
+                telemetry_cmd_exec(cLine);
+            }
+            uiLen = 0;
+        }
+        else if (uiLen < sizeof(cLine) - 1)
+        {
+            cLine[uiLen++] = (char)ucChar;
+        }
+    }
+}
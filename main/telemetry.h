@@ -0,0 +1,110 @@
+/**
+ * @file telemetry.h
+ * Per-refresh timing, heap and stack watermarks kept in a RAM ring and dumped on a UART command
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TELEMETRY_RING_SIZE         (128)   /* records, the oldest ones are overwritten */
+#define TELEMETRY_SYS_PERIOD_MS     (1000)  /* heap and stack sampling, they are too slow for every refresh */
+#define TELEMETRY_TASKS_MAX         (2)     /* tasks whose stack watermark is sampled */
+#define TELEMETRY_CMD_LINE_MAX      (32)
+#define TELEMETRY_CMDS_MAX          (4)     /* console commands, "tlm" included */
+
+/* "tlm csv" dumps the ring as text lines starting with "tlm,", "tlm bin" as one binary frame:
+   "TLM1", uint16 record size, uint16 record count, records, uint16 Fletcher-16 of the records.
+   "tlm clear" empties the ring. tools/telemetry_plot.py reads both from a serial capture. */
+#define TELEMETRY_BIN_MAGIC         "TLM1"
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef enum
+{
+    TELEMETRY_REC_FRAME = 0,
+    TELEMETRY_REC_SYS,
+} telemetry_rec_type_t;
+
+/* One record of the ring, little endian and packed the same way in the binary dump */
+typedef struct
+{
+    uint32_t uiTime;                /* ms since boot */
+    uint16_t usType;                /* telemetry_rec_type_t */
+    uint16_t usAreas;               /* frame: flushes of the refresh */
+    union
+    {
+        struct
+        {
+            uint32_t uiRenderUs;    /* refresh time without flush and wait, 1 ms resolution */
+            uint32_t uiFlushUs;     /* CPU time in disp_driver_flush() */
+            uint32_t uiWaitUs;      /* blocked in wait_cb for the bus */
+            uint32_t uiPx;
+        } tFrame;
+        struct
+        {
+            uint32_t uiFreeHeap;
+            uint32_t uiLvFree;      /* bytes free in the LVGL heap */
+            uint8_t ucLvFragPct;
+            uint8_t ucLvUsedPct;
+            uint16_t usSampleUs;    /* what taking the previous system sample cost */
+            uint16_t ausStackFree[TELEMETRY_TASKS_MAX]; /* bytes never used, 0 for no task */
+        } tSys;
+    } u;
+} telemetry_rec_t;
+
+/* Handler of a console command, pcArgs is what follows the command name and a space, or "" */
+typedef void (*telemetry_cmd_cb_t)(const char* pcArgs);
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* Create the task that reads commands from the console UART */
+void telemetry_init(uint32_t uiPriority);
+
+/* Hand console lines starting with the word pcName to pfnCb, called from the telemetry task.
+   pcName must be a static string */
+void telemetry_add_cmd(const char* pcName, telemetry_cmd_cb_t pfnCb);
+
+/* Sample the stack watermark of ptTask, at most TELEMETRY_TASKS_MAX tasks */
+void telemetry_watch_task(TaskHandle_t ptTask);
+
+/* Record one refresh, call from the display monitor_cb with its arguments. guiTask only */
+void telemetry_frame(uint32_t uiRefrMs, uint32_t uiPx);
+
+/* Account uiCycles spent waiting for a flush to leave the bus, guiTask only */
+void telemetry_add_wait(uint32_t uiCycles);
+
+/* Record heap and stack watermarks once every TELEMETRY_SYS_PERIOD_MS, call from the guiTask loop */
+void telemetry_sample_sys(void);
+
+/* Write the ring to the console UART */
+void telemetry_dump_csv(void);
+void telemetry_dump_bin(void);
+void telemetry_clear(void);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* TELEMETRY_H */
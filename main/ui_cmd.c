@@ -0,0 +1,234 @@
+/**
+ * @file ui_cmd.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "ui_cmd.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+{
+    ui_cmd_op_t eOp;
+    lv_obj_t* ptObj;
+    union
+    {
+        char cText[UI_CMD_TEXT_MAX];
+        bool bOn;
+    } uArg;
+} ui_cmd_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static ui_cmd_t* ui_cmd_slot(ui_cmd_op_t eOp, lv_obj_t* ptObj);
+static void ui_cmd_post_done(bool bPosted);
+static void ui_cmd_exec(const ui_cmd_t* ptCmd);
+static void ui_cmd_delete_cb(lv_event_t* ptEvent);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+/* Ring of pending commands, producers and guiTask only touch it inside a short critical
+   section. The ESP8266 has no compare-and-swap, masking interrupts for a few copies is cheaper
+   than a mutex and no producer can be preempted while holding it */
+static ui_cmd_t s_atRing[UI_CMD_QUEUE_SIZE];
+static uint32_t s_uiHead = 0;               /* next free slot */
+static uint32_t s_uiTail = 0;               /* oldest pending command */
+static uint32_t s_uiDropped = 0;
+static void (*s_pfnWake)(void) = NULL;
+
+/**********************
+ *      MACROS
+ **********************/
+#define RING_CNT()          (s_uiHead - s_uiTail)
+#define RING_AT(i)          (&s_atRing[(i) % UI_CMD_QUEUE_SIZE])
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void ui_cmd_init(void (*pfnWake)(void))
+{
+    s_pfnWake = pfnWake;
+}
+
+bool ui_cmd_set_label_text(lv_obj_t* ptLabel, const char* pcText)
+{
+    portENTER_CRITICAL();
+    ui_cmd_t* ptCmd = ui_cmd_slot(UI_CMD_LABEL_TEXT, ptLabel);
+    if (ptCmd)
+    {
+        strncpy(ptCmd->uArg.cText, pcText ? pcText : "", UI_CMD_TEXT_MAX - 1);
+        ptCmd->uArg.cText[UI_CMD_TEXT_MAX - 1] = '\0';
+    }
+    portEXIT_CRITICAL();
+
+    ui_cmd_post_done(ptCmd != NULL);
+    return ptCmd != NULL;
+}
+
+bool ui_cmd_set_switch_state(lv_obj_t* ptSwitch, bool bOn)
+{
+    portENTER_CRITICAL();
+    ui_cmd_t* ptCmd = ui_cmd_slot(UI_CMD_SWITCH_STATE, ptSwitch);
+    if (ptCmd)
+    {
+        ptCmd->uArg.bOn = bOn;
+    }
+    portEXIT_CRITICAL();
+
+    ui_cmd_post_done(ptCmd != NULL);
+    return ptCmd != NULL;
+}
+
+bool ui_cmd_invalidate(lv_obj_t* ptObj)
+{
+    portENTER_CRITICAL();
+    ui_cmd_t* ptCmd = ui_cmd_slot(UI_CMD_INVALIDATE, ptObj);
+    portEXIT_CRITICAL();
+
+    ui_cmd_post_done(ptCmd != NULL);
+    return ptCmd != NULL;
+}
+
+uint32_t ui_cmd_drain(uint32_t uiMax)
+{
+    ui_cmd_t tCmd;
+    uint32_t uiLeft;
+
+    while (uiMax--)
+    {
+        /* Copy out and release the slot first, LVGL runs without the interrupts masked */
+        portENTER_CRITICAL();
+        if (RING_CNT() == 0)
+        {
+            portEXIT_CRITICAL();
+            break;
+        }
+        tCmd = *RING_AT(s_uiTail);
+        s_uiTail++;
+        portEXIT_CRITICAL();
+
+        ui_cmd_exec(&tCmd);
+    }
+
+    portENTER_CRITICAL();
+    uiLeft = RING_CNT();
+    portEXIT_CRITICAL();
+    return uiLeft;
+}
+
+void ui_cmd_forget(lv_obj_t* ptObj)
+{
+    uint32_t i;
+
+    /* The slots stay in the ring, without an object they are skipped when drained */
+    portENTER_CRITICAL();
+    for (i = s_uiTail; i != s_uiHead; i++)
+    {
+        ui_cmd_t* ptCmd = RING_AT(i);
+        if (ptCmd->ptObj == ptObj)
+        {
+            ptCmd->ptObj = NULL;
+        }
+    }
+    portEXIT_CRITICAL();
+}
+
+void ui_cmd_watch(lv_obj_t* ptObj)
+{
+    lv_obj_add_event_cb(ptObj, ui_cmd_delete_cb, LV_EVENT_DELETE, NULL);
+}
+
+uint32_t ui_cmd_get_dropped(void)
+{
+    return s_uiDropped;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/* Pending slot of the same object and operation, or a new one at the head. Critical section held */
+static ui_cmd_t* ui_cmd_slot(ui_cmd_op_t eOp, lv_obj_t* ptObj)
+{
+    uint32_t i;
+    for (i = s_uiTail; i != s_uiHead; i++)
+    {
+        ui_cmd_t* ptCmd = RING_AT(i);
+        if (ptCmd->eOp == eOp && ptCmd->ptObj == ptObj)
+        {
+            return ptCmd;
+        }
+    }
+
+    if (RING_CNT() >= UI_CMD_QUEUE_SIZE)
+    {
+        s_uiDropped++;
+        return NULL;
+    }
+
+    ui_cmd_t* ptCmd = RING_AT(s_uiHead);
+    ptCmd->eOp = eOp;
+    ptCmd->ptObj = ptObj;
+    s_uiHead++;
+    return ptCmd;
+}
+
+static void ui_cmd_post_done(bool bPosted)
+{
+    if (bPosted && s_pfnWake)
+    {
+        s_pfnWake();
+    }
+}
+
+static void ui_cmd_exec(const ui_cmd_t* ptCmd)
+{
+    /* Forgotten, or deleted without being watched */
+    if (ptCmd->ptObj == NULL || !lv_obj_is_valid(ptCmd->ptObj))
+    {
+        return;
+    }
+
+    switch (ptCmd->eOp)
+    {
+    case UI_CMD_LABEL_TEXT:
+        lv_label_set_text(ptCmd->ptObj, ptCmd->uArg.cText);
+        break;
+    case UI_CMD_SWITCH_STATE:
+        if (ptCmd->uArg.bOn)
+        {
+            lv_obj_add_state(ptCmd->ptObj, LV_STATE_CHECKED);
+        }
+        else
+        {
+            lv_obj_clear_state(ptCmd->ptObj, LV_STATE_CHECKED);
+        }
+        break;
+    case UI_CMD_INVALIDATE:
+        lv_obj_invalidate(ptCmd->ptObj);
+        break;
+    default:
+        break;
+    }
+}
+
+static void ui_cmd_delete_cb(lv_event_t* ptEvent)
+{
+    ui_cmd_forget(lv_event_get_target(ptEvent));
+}
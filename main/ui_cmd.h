@@ -0,0 +1,72 @@
+/**
+ * @file ui_cmd.h
+ * UI updates posted from any task, executed by guiTask
+ */
+
+#ifndef UI_CMD_H
+#define UI_CMD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define UI_CMD_QUEUE_SIZE           (32)    /* commands pending at most, after coalescing */
+#define UI_CMD_TEXT_MAX             (32)    /* label text is copied, longer text is cut */
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef enum
+{
+    UI_CMD_LABEL_TEXT = 0,
+    UI_CMD_SWITCH_STATE,
+    UI_CMD_INVALIDATE,
+} ui_cmd_op_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* pfnWake is called after every post, it should wake the task that calls ui_cmd_drain() */
+void ui_cmd_init(void (*pfnWake)(void));
+
+/* Post from any task, never blocks. A command for the same object and operation that is still
+   pending is overwritten in place, so a burst of updates ends in one redraw.
+   Returns false when the queue is full and the command was dropped.
+   Objects deleted while commands are pending have to be watched, see ui_cmd_watch() */
+bool ui_cmd_set_label_text(lv_obj_t* ptLabel, const char* pcText);
+bool ui_cmd_set_switch_state(lv_obj_t* ptSwitch, bool bOn);
+bool ui_cmd_invalidate(lv_obj_t* ptObj);
+
+/* Execute up to uiMax pending commands in posting order, guiTask only.
+   Returns the number of commands still pending */
+uint32_t ui_cmd_drain(uint32_t uiMax);
+
+/* guiTask only: drop the pending commands of an object that is being deleted */
+void ui_cmd_forget(lv_obj_t* ptObj);
+
+/* guiTask only: call ui_cmd_forget() from the LV_EVENT_DELETE of an object other tasks post to */
+void ui_cmd_watch(lv_obj_t* ptObj);
+
+/* Commands dropped because the queue was full */
+uint32_t ui_cmd_get_dropped(void);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* UI_CMD_H */
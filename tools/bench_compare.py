@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""Per scene FPS of two lv_demo_benchmark runs side by side.
+
+    python3 tools/bench_compare.py before.log after.log
+
+The inputs are serial logs or files with the CSV report (LV_DEMO_BENCHMARK_REPORT 1), e.g. a
+build with main/linker.lf emptied and CONFIG_LV_ATTRIBUTE_FAST_MEM_USE_IRAM off against the
+normal one. Lines around the report are skipped, scenes missing in one of the runs are listed
+with "-". The table is plain text to be pasted into a commit message.
+"""
+
+import argparse
+import sys
+
+
+def read_report(path):
+    """{(scene, opa): fps} of the first CSV report in path"""
+    rows = {}
+    header = None
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            # Serial logs may carry a prefix in front of the header
+            pos = line.find("scene,opa,refr_cnt,")
+            if header is None:
+                if pos >= 0:
+                    header = line[pos:].split(",")
+                continue
+            fields = line.split(",")
+            if len(fields) != len(header):
+                break
+            row = dict(zip(header, fields))
+            rows[(row["scene"], int(row["opa"]))] = int(row["fps"])
+    if header is None:
+        sys.exit("%s: no CSV report, build with LV_DEMO_BENCHMARK_REPORT 1" % path)
+    return rows
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("before")
+    ap.add_argument("after")
+    args = ap.parse_args()
+
+    before = read_report(args.before)
+    after = read_report(args.after)
+    keys = list(before) + [k for k in after if k not in before]
+
+    print("%-32s %3s %7s %7s %7s" % ("scene", "opa", "before", "after", "change"))
+    sum_before = sum_after = 0
+    for scene, opa in keys:
+        b = before.get((scene, opa))
+        a = after.get((scene, opa))
+        change = "%+.1f%%" % (100.0 * (a - b) / b) if a is not None and b else "-"
+        print("%-32.32s %3d %7s %7s %7s" % (scene, opa, "-" if b is None else b, "-" if a is None else a, change))
+        if a is not None and b is not None:
+            sum_before += b
+            sum_after += a
+    if sum_before:
+        print("%-32s %3s %7d %7d %+6.1f%%" % ("sum of common scenes", "", sum_before, sum_after,
+                                              100.0 * (sum_after - sum_before) / sum_before))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Report what the firmware puts into IRAM and what is left to the heap.
+
+    python3 tools/iram_report.py build/app.elf
+    python3 tools/iram_report.py build/app.elf --sdkconfig sdkconfig --top 40
+    python3 tools/iram_report.py build/app.elf --before build_noiram/app.elf
+
+On the ESP8266 the IRAM that code does not use is added to the heap, so every function
+placed with IRAM_ATTR, LV_ATTRIBUTE_FAST_MEM or main/linker.lf costs heap of the same size.
+Functions of the display path (LVGL draw, SPI and panel driver) are listed separately.
+With --before, the IRAM of a build without the change (e.g. main/linker.lf emptied and
+CONFIG_LV_ATTRIBUTE_FAST_MEM_USE_IRAM off) is reported next to it, for the commit message.
+"""
+
+import argparse
+import re
+import subprocess
+
+IRAM_START = 0x40100000
+# Functions that belong to the display path, by name
+DISPLAY_PATH = re.compile(r"^(lv_draw_sw|lv_color_fill|lv_memcpy|lv_memset|_lv_area|fill_|map_|blend_|"
+                          r"lvgl_spi|lvgl_flush|disp_spi|disp_driver|ili9341|ili9488)")
+
+
+def iram_size(sdkconfig):
+    with open(sdkconfig) as f:
+        for line in f:
+            m = re.match(r"CONFIG_SOC_IRAM_SIZE=(0x[0-9a-fA-F]+|\d+)", line)
+            if m:
+                return int(m.group(1), 0)
+    return 0x8000
+
+
+def iram_funcs(nm, elf, size):
+    """IRAM bytes used by the code of elf and its functions there as (size, name)"""
+    out = subprocess.run([nm, "-n", "-S", "--defined-only", elf], check=True,
+                         capture_output=True, text=True).stdout
+
+    funcs = []
+    end = IRAM_START
+    for line in out.splitlines():
+        f = line.split()
+        if len(f) != 4:
+            continue
+        addr, fsize = int(f[0], 16), int(f[1], 16)
+        if IRAM_START <= addr < IRAM_START + size:
+            end = max(end, addr + fsize)
+            if f[2] in "tTwW":
+                funcs.append((fsize, f[3]))
+    return end - IRAM_START, funcs
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("elf")
+    ap.add_argument("--sdkconfig", default="sdkconfig")
+    ap.add_argument("--nm", default="xtensa-lx106-elf-nm")
+    ap.add_argument("--top", type=int, default=20)
+    ap.add_argument("--before", metavar="ELF", help="build to compare with")
+    args = ap.parse_args()
+
+    size = iram_size(args.sdkconfig)
+    used, funcs = iram_funcs(args.nm, args.elf, size)
+    print("IRAM %d bytes, code %d bytes (%.1f%%), %d bytes left to the heap" %
+          (size, used, 100.0 * used / size, size - used))
+    if args.before:
+        used_before, funcs_before = iram_funcs(args.nm, args.before, size)
+        print("before: code %d bytes, %+d bytes of IRAM, %+d functions" %
+              (used_before, used - used_before, len(funcs) - len(funcs_before)))
+
+    display = sorted((fn for fn in funcs if DISPLAY_PATH.match(fn[1])), reverse=True)
+    print("\nDisplay path in IRAM: %d functions, %d bytes" % (len(display), sum(s for s, _ in display)))
+    for fsize, name in display:
+        print("%8d  %s" % (fsize, name))
+
+    print("\nLargest IRAM functions")
+    for fsize, name in sorted(funcs, reverse=True)[:args.top]:
+        print("%8d  %s" % (fsize, name))
+
+
+if __name__ == "__main__":
+    main()
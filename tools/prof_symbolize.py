@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""Symbolize a "prof dump" of the device against the firmware ELF.
+
+    python3 tools/prof_symbolize.py capture.log build/app.elf
+    python3 tools/prof_symbolize.py capture.log build/app.elf --top 30 --nm xtensa-lx106-elf-nm
+    python3 tools/prof_symbolize.py capture.log build/app.elf --lf iram.lf --libs build/*/lib*.a
+
+Prints a flat profile by function, with the memory the function runs from, and a caller
+profile: the sampled functions with the callers the profiler found for them, then the
+samples summed by caller. Callers are a hint, see profiler_caller() in main/profiler.c.
+
+With --lf the hottest functions still running from flash are written as a linker fragment
+that moves them into IRAM, until --budget bytes are used. Merge it into main/linker.lf.
+"""
+
+import argparse
+import bisect
+import collections
+import os
+import subprocess
+import sys
+
+
+def region(addr):
+    if 0x40100000 <= addr < 0x40110000:
+        return "iram"
+    if 0x40200000 <= addr < 0x40300000:
+        return "flash"
+    if 0x40000000 <= addr < 0x40010000:
+        return "rom"
+    return "?"
+
+
+class Symbols:
+    def __init__(self, elf, nm):
+        out = subprocess.run([nm, "-n", "-S", "--defined-only", elf], check=True,
+                             capture_output=True, text=True).stdout
+        self.addrs, self.syms = [], []
+        for line in out.splitlines():
+            f = line.split()
+            if len(f) == 4 and f[2] in "tTwW":
+                self.addrs.append(int(f[0], 16))
+                self.syms.append((int(f[1], 16), f[3]))
+        self.sizes = {name: size for size, name in self.syms}
+
+    def size(self, name):
+        return self.sizes.get(name, 0)
+
+    def lookup(self, addr):
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        if addr and i >= 0:
+            size, name = self.syms[i]
+            if addr < self.addrs[i] + max(size, 1):
+                return name, size
+        return None, 0
+
+    def name(self, addr):
+        if addr == 0:
+            return "<unknown>"
+        return self.lookup(addr)[0] or "%s@%08x" % (region(addr), addr)
+
+
+def objects(libs, nm):
+    """Map function names to the (archive, object) defining them, for linker fragment entries."""
+    where = {}
+    for lib in libs:
+        out = subprocess.run([nm, "-A", "--defined-only", lib], capture_output=True, text=True).stdout
+        for line in out.splitlines():
+            f = line.split()
+            if len(f) != 3 or f[1] not in "tTwW":
+                continue
+            parts = f[0].split(":")
+            if len(parts) >= 2:
+                where.setdefault(f[2], (os.path.basename(parts[0]), os.path.splitext(parts[1])[0]))
+    return where
+
+
+def write_lf(path, hot, syms, where, budget, source):
+    """hot: function names by falling sample count. Returns the bytes placed."""
+    used = 0
+    by_lib = collections.OrderedDict()
+    for fn in hot:
+        if fn not in where:
+            print("prof: %s not found in --libs, skipped" % fn, file=sys.stderr)
+            continue
+        size = syms.size(fn)
+        if used + size > budget:
+            continue
+        used += size
+        lib, obj = where[fn]
+        by_lib.setdefault(lib, []).append((obj, fn, size))
+
+    with open(path, "w") as f:
+        f.write("# Generated by tools/prof_symbolize.py from %s, %d bytes of IRAM\n" % (source, used))
+        for lib, entries in by_lib.items():
+            f.write("\n[mapping:prof_iram_%s]\n" % os.path.splitext(lib)[0].replace("lib", "", 1))
+            f.write("archive: %s\n" % lib)
+            f.write("entries:\n")
+            for obj, fn, size in entries:
+                f.write("    %s:%s (noflash)    # %d bytes\n" % (obj, fn, size))
+    return used
+
+
+def parse(text):
+    """Return (samples, hz, lost) of the last dump, samples as (pc, caller, count)."""
+    block, last = None, None
+    for line in text.splitlines():
+        f = line.strip().split(",")
+        if f[0] != "prof":
+            continue
+        if f[1] == "begin":
+            block, hz, lost = [], int(f[3]), int(f[4])
+        elif f[1] == "end":
+            if block is not None:
+                last = (block, hz, lost)
+                block = None
+        elif block is not None and len(f) == 4:
+            block.append((int(f[1], 16), int(f[2], 16), int(f[3])))
+    return last
+
+
+def table(title, rows, total, top):
+    print("\n%s" % title)
+    print("%8s %7s  %-6s %s" % ("samples", "%", "where", "function"))
+    for name, cnt, where in rows[:top]:
+        print("%8d %6.2f%%  %-6s %s" % (cnt, 100.0 * cnt / total, where, name))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("capture", help="serial capture holding a prof dump")
+    ap.add_argument("elf", help="the firmware the samples were taken with")
+    ap.add_argument("--nm", default="xtensa-lx106-elf-nm")
+    ap.add_argument("--top", type=int, default=20)
+    ap.add_argument("--lf", help="write a linker fragment placing the hot flash functions into IRAM")
+    ap.add_argument("--libs", nargs="+", default=[], help="component archives, to find the object of a function")
+    ap.add_argument("--budget", type=int, default=4096, help="IRAM bytes the fragment may use")
+    args = ap.parse_args()
+
+    with open(args.capture, "rb") as f:
+        res = parse(f.read().decode("latin-1"))
+    if res is None:
+        sys.exit("prof: no complete dump found")
+    samples, hz, lost = res
+    total = sum(c for _, _, c in samples)
+    if total == 0:
+        sys.exit("prof: the dump holds no samples")
+
+    syms = Symbols(args.elf, args.nm)
+    flat = collections.Counter()
+    where = {}
+    callers = collections.defaultdict(collections.Counter)
+    by_caller = collections.Counter()
+    for pc, caller, cnt in samples:
+        fn = syms.name(pc)
+        flat[fn] += cnt
+        where[fn] = region(pc)
+        cname = syms.name(caller)
+        callers[fn][cname] += cnt
+        by_caller[cname] += cnt
+
+    print("%d samples at %d Hz, %.2f s sampled, %d lost to a full buffer" % (total, hz, total / hz, lost))
+
+    rows = [(fn, cnt, where[fn]) for fn, cnt in flat.most_common()]
+    table("Flat profile", rows, total, args.top)
+
+    print("\nCallers of the hottest functions")
+    for fn, cnt, _ in rows[:args.top]:
+        print("%8d %s" % (cnt, fn))
+        for cname, ccnt in callers[fn].most_common(3):
+            print("%8d     <- %s" % (ccnt, cname))
+
+    rows = [(cname, cnt, "") for cname, cnt in by_caller.most_common()]
+    table("Samples by caller", rows, total, args.top)
+
+    hot_flash = [fn for fn, _ in flat.most_common(args.top) if where[fn] == "flash"]
+    if hot_flash:
+        print("\nHot functions running from flash, IRAM candidates: %s" % ", ".join(hot_flash))
+
+    if args.lf:
+        used = write_lf(args.lf, hot_flash, syms, objects(args.libs, args.nm), args.budget, args.capture)
+        print("%s: %d bytes of IRAM, check the total with tools/iram_report.py" % (args.lf, used))
+
+
+if __name__ == "__main__":
+    main()
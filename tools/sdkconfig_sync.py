@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Write the main/Kconfig.projbuild options into sdkconfig the way menuconfig does.
+
+    python3 tools/sdkconfig_sync.py --check
+    python3 tools/sdkconfig_sync.py
+
+For a tree without the SDK's menuconfig at hand. Only the block of main is touched, it is
+emitted where confgen puts it: after the esptool_py options and before the partition table,
+in Kconfig order. Like confgen, a bool that is off is written as "# CONFIG_X is not set",
+options whose "depends on" is off are left out, a value already in sdkconfig is kept and a
+new option gets its default. Understands the subset of Kconfig main uses.
+"""
+
+import argparse
+import re
+import sys
+
+
+def parse_kconfig(path):
+    """Options of path in Kconfig order"""
+    opts = []
+    in_help = False
+    with open(path) as f:
+        for line in f:
+            s = line.strip()
+            m = re.match(r"config (\w+)$", s)
+            if m:
+                opts.append({"name": m.group(1), "type": None, "prompt": False,
+                             "default": None, "depends": None, "default_if": None})
+                in_help = False
+                continue
+            if s.startswith(("menu", "endmenu")):
+                in_help = False
+                continue
+            if s == "help":
+                in_help = True
+            if not opts or in_help:
+                continue
+            o = opts[-1]
+            m = re.match(r"(bool|int|string|hex)\b\s*(\".*\")?$", s)
+            if m and o["type"] is None:
+                o["type"] = m.group(1)
+                o["prompt"] = m.group(2) is not None
+                continue
+            m = re.match(r"default (\".*?\"|\S+)(?: if (.*))?$", s)
+            if m and o["default"] is None:
+                o["default"] = m.group(1)
+                o["default_if"] = m.group(2)
+                continue
+            m = re.match(r"depends on (\w+)$", s)
+            if m:
+                o["depends"] = m.group(1)
+    return opts
+
+
+def read_values(lines):
+    values = {}
+    for line in lines:
+        m = re.match(r"CONFIG_(\w+)=(.*)$", line)
+        if m:
+            values[m.group(1)] = m.group(2)
+        m = re.match(r"# CONFIG_(\w+) is not set$", line)
+        if m:
+            values[m.group(1)] = "n"
+    return values
+
+
+def condition(expr, values):
+    """The "A = \"x\"" and "A" conditions main uses"""
+    m = re.match(r"(\w+) = (\".*\")$", expr)
+    if m:
+        return values.get(m.group(1)) == m.group(2)
+    return values.get(expr, "n") not in ("n", None)
+
+
+def emit(opts, values):
+    lines = []
+    for o in opts:
+        if o["depends"] and not condition(o["depends"], values):
+            values.pop(o["name"], None)
+            continue
+        if not o["prompt"]:
+            # Invisible, only written when its default applies
+            on = o["default_if"] is None or condition(o["default_if"], values)
+            value = o["default"] if on else None
+        else:
+            value = values.get(o["name"], o["default"])
+        if o["type"] == "bool":
+            value = "y" if value == "y" else "n"
+            if value == "n" and not o["prompt"]:
+                continue
+            lines.append("CONFIG_%s=y" % o["name"] if value == "y" else "# CONFIG_%s is not set" % o["name"])
+        elif value is not None:
+            lines.append("CONFIG_%s=%s" % (o["name"], value))
+        else:
+            continue
+        values[o["name"]] = value
+    return lines
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--sdkconfig", default="sdkconfig")
+    ap.add_argument("--kconfig", default="main/Kconfig.projbuild")
+    ap.add_argument("--check", action="store_true", help="only report, exit 1 when out of date")
+    args = ap.parse_args()
+
+    opts = parse_kconfig(args.kconfig)
+    names = {o["name"] for o in opts}
+    with open(args.sdkconfig) as f:
+        lines = f.read().splitlines()
+
+    def is_main(line):
+        m = re.match(r"(?:# )?CONFIG_(\w+)(?:=| is not set)", line)
+        return m is not None and m.group(1) in names
+
+    # confgen's place of main: behind the last esptool_py option
+    anchor = max(i for i, line in enumerate(lines) if re.match(r"(?:# )?CONFIG_ESPTOOLPY_", line))
+    kept = [line for line in lines if not is_main(line)]
+    anchor = kept.index(lines[anchor]) + 1
+    block = emit(opts, read_values(lines))
+    out = kept[:anchor] + block + kept[anchor:]
+
+    if out == lines:
+        print("%s: %d options of %s in place" % (args.sdkconfig, len(block), args.kconfig))
+        return 0
+    if args.check:
+        print("%s: options of %s out of date, run %s" % (args.sdkconfig, args.kconfig, sys.argv[0]))
+        return 1
+    with open(args.sdkconfig, "w") as f:
+        f.write("\n".join(out) + "\n")
+    print("%s: wrote %d options of %s" % (args.sdkconfig, len(block), args.kconfig))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""Turn a telemetry dump of the device into CSV files and plots.
+
+Capture the console while sending "tlm csv" or "tlm bin", e.g.
+
+    python3 tools/telemetry_plot.py --port /dev/ttyUSB0 --cmd bin --out tlm
+    python3 tools/telemetry_plot.py capture.log --out tlm
+
+Log lines around the dump are skipped. Writes <out>_frames.csv and <out>_sys.csv, and
+<out>.png when matplotlib is installed. The record layout is telemetry_rec_t in main/telemetry.h.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+import time
+
+MAGIC = b"TLM1"
+REC_FRAME = 0
+REC_SYS = 1
+TASKS_MAX = 2
+FRAME_COLS = ["time_ms", "areas", "render_us", "flush_us", "wait_us", "px"]
+SYS_COLS = ["time_ms", "heap", "lv_free", "lv_frag_pct", "lv_used_pct", "sample_us"]
+
+
+def fletcher16(data):
+    s1 = s2 = 0
+    for b in data:
+        s1 = (s1 + b) % 255
+        s2 = (s2 + s1) % 255
+    return (s2 << 8) | s1
+
+
+def parse_bin(raw):
+    """Return (frames, sys, stack columns) of the last complete binary dump in raw, or None."""
+    pos = raw.rfind(MAGIC)
+    while pos >= 0:
+        hdr = raw[pos + 4:pos + 8]
+        if len(hdr) == 4:
+            size, cnt = struct.unpack("<HH", hdr)
+            body = raw[pos + 8:pos + 8 + size * cnt]
+            tail = raw[pos + 8 + size * cnt:pos + 10 + size * cnt]
+            if len(body) == size * cnt and len(tail) == 2:
+                if struct.unpack("<H", tail)[0] == fletcher16(body):
+                    return decode_bin(body, size, cnt)
+                print("telemetry: checksum mismatch, a log line got into the dump, dump again",
+                      file=sys.stderr)
+        pos = raw.rfind(MAGIC, 0, pos)
+    return None
+
+
+def decode_bin(body, size, cnt):
+    frames, sysrecs = [], []
+    for i in range(cnt):
+        rec = body[i * size:(i + 1) * size]
+        t, typ, areas = struct.unpack_from("<IHH", rec, 0)
+        if typ == REC_FRAME:
+            render, flush, wait, px = struct.unpack_from("<IIII", rec, 8)
+            frames.append([t, areas, render, flush, wait, px])
+        elif typ == REC_SYS:
+            heap, lv_free, frag, used, sample = struct.unpack_from("<IIBBH", rec, 8)
+            stacks = struct.unpack_from("<%dH" % TASKS_MAX, rec, 20)
+            sysrecs.append([t, heap, lv_free, frag, used, sample] + list(stacks))
+    stack_cols = ["stack_%d" % i for i in range(TASKS_MAX)]
+    return frames, sysrecs, stack_cols
+
+
+def parse_csv(text):
+    """Return (frames, sys, stack columns) of the last "tlm,begin" .. "tlm,end" block, or None."""
+    lines = text.splitlines()
+    begin = None
+    for i, line in enumerate(lines):
+        if line.startswith("tlm,begin"):
+            begin = i
+    if begin is None:
+        return None
+    frames, sysrecs, stack_cols = [], [], []
+    for line in lines[begin + 1:]:
+        if not line.startswith("tlm,"):
+            continue
+        f = line.strip().split(",")
+        if f[1] == "end":
+            break
+        if f[1] == "#S":
+            stack_cols = f[2 + len(SYS_COLS):]
+        elif f[1] == "F" and len(f) == 2 + len(FRAME_COLS):
+            frames.append([int(v) for v in f[2:]])
+        elif f[1] == "S" and len(f) >= 2 + len(SYS_COLS):
+            sysrecs.append([int(v) for v in f[2:]])
+    return frames, sysrecs, stack_cols
+
+
+def capture(port, baud, cmd, seconds):
+    import serial  # pyserial
+
+    with serial.Serial(port, baud, timeout=0.2) as ser:
+        ser.reset_input_buffer()
+        ser.write(("tlm %s\n" % cmd).encode())
+        raw = b""
+        end = time.time() + seconds
+        while time.time() < end:
+            raw += ser.read(4096)
+    return raw
+
+
+def write_csv(path, cols, rows):
+    with open(path, "w", newline="") as f:
+        w = csv.writer(f)
+        w.writerow(cols)
+        w.writerows(rows)
+
+
+def plot(path, frames, sysrecs, stack_cols):
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print("telemetry: matplotlib not installed, no plot", file=sys.stderr)
+        return
+
+    fig, ax = plt.subplots(3, 1, figsize=(10, 9), sharex=True)
+    if frames:
+        t = [r[0] / 1000.0 for r in frames]
+        render = [r[2] / 1000.0 for r in frames]
+        flush = [r[3] / 1000.0 for r in frames]
+        wait = [r[4] / 1000.0 for r in frames]
+        ax[0].stackplot(t, render, flush, wait, labels=["render", "flush", "wait"])
+        ax[0].set_ylabel("ms / refresh")
+        ax[0].legend(loc="upper right")
+        ax[1].plot(t, [r[5] for r in frames], label="px")
+        ax[1].set_ylabel("px / refresh")
+        ax1b = ax[1].twinx()
+        ax1b.plot(t, [r[1] for r in frames], "r.", label="areas")
+        ax1b.set_ylabel("areas")
+    if sysrecs:
+        t = [r[0] / 1000.0 for r in sysrecs]
+        ax[2].plot(t, [r[1] for r in sysrecs], label="free heap")
+        ax[2].plot(t, [r[2] for r in sysrecs], label="LVGL free")
+        for i, name in enumerate(stack_cols):
+            ax[2].plot(t, [r[len(SYS_COLS) + i] for r in sysrecs], label=name)
+        ax[2].set_ylabel("bytes")
+        ax[2].legend(loc="upper right")
+    ax[2].set_xlabel("s")
+    fig.tight_layout()
+    fig.savefig(path)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("capture", nargs="?", help="serial capture holding a dump")
+    ap.add_argument("--port", help="read the dump from this serial port instead")
+    ap.add_argument("--baud", type=int, default=74880)
+    ap.add_argument("--cmd", choices=["csv", "bin"], default="bin")
+    ap.add_argument("--seconds", type=float, default=3.0, help="how long to listen on --port")
+    ap.add_argument("--out", default="telemetry")
+    args = ap.parse_args()
+
+    if args.port:
+        raw = capture(args.port, args.baud, args.cmd, args.seconds)
+    elif args.capture:
+        with open(args.capture, "rb") as f:
+            raw = f.read()
+    else:
+        ap.error("give a capture file or --port")
+
+    res = parse_bin(raw) or parse_csv(raw.decode("latin-1"))
+    if res is None:
+        sys.exit("telemetry: no dump found")
+    frames, sysrecs, stack_cols = res
+
+    write_csv(args.out + "_frames.csv", FRAME_COLS, frames)
+    write_csv(args.out + "_sys.csv", SYS_COLS + stack_cols, sysrecs)
+    plot(args.out + ".png", frames, sysrecs, stack_cols)
+
+    if frames:
+        busy = sum(r[2] + r[3] + r[4] for r in frames) / len(frames) / 1000.0
+        print("%d refreshes, %.2f ms average, %d system samples" % (len(frames), busy, len(sysrecs)))
+    if sysrecs:
+        cost = max(r[5] for r in sysrecs)
+        print("system sample cost up to %u us" % cost)
+
+
+if __name__ == "__main__":
+    main()